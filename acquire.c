@@ -0,0 +1,333 @@
+// acquire.c - Background Acquisition Module
+
+#include "acquire.h"
+#include "archive.h"
+#include "binlog.h"
+#include "instrument.h"
+#include "ingest.h"
+#include "platform.h"
+#include "simulator.h"
+#include "store.h"
+#include "tail.h"
+#include "workload.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(RingSample) == sizeof(BinlogRecord), "ring samples mirror binary log records");
+
+// Worker side batching, readings are published ACQUIRE_BATCH at a time
+typedef struct {
+    Acquisition *a;
+    RingSample batch[ACQUIRE_BATCH];
+    size_t n;
+    size_t remaining;        // Readings still to take from the source
+    size_t taken;            // Readings taken from the source so far
+    bool stopped;            // Stop requested, nothing more is published
+    bool complete;           // The file source was read to its end, set by the run functions
+} Publisher;
+
+bool acquire_init(Acquisition *a, size_t ring_capacity) {
+    memset(a, 0, sizeof(*a));
+    workload_defaults(&a->workload);
+    return ring_init(&a->ring, ring_capacity);
+}
+
+void acquire_free(Acquisition *a) {
+    acquire_stop(a);
+    ring_free(&a->ring);
+}
+
+static bool stop_requested(Acquisition *a) {
+    return atomic_load_explicit(&a->stop, memory_order_relaxed);
+}
+
+// Sleeps in short steps so a stop request is noticed quickly
+static void pause_ms(Acquisition *a, int ms) {
+    while (ms > 0 && !stop_requested(a)) {
+        int step = ms < ACQUIRE_STOP_POLL_MS ? ms : ACQUIRE_STOP_POLL_MS;
+        sleep_ms(step);
+        ms -= step;
+    }
+}
+
+// Remembers when the readings up to end were pushed
+static void mark_push(Acquisition *a, unsigned long long end) {
+    size_t head = atomic_load_explicit(&a->mark_head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&a->mark_tail, memory_order_acquire) >= ACQUIRE_MARKS) return;
+
+    AcquireMark *m = &a->marks[head & (ACQUIRE_MARKS - 1)];
+    m->end = end;
+    m->ns = instrument_now_ns();
+    atomic_store_explicit(&a->mark_head, head + 1, memory_order_release);
+}
+
+// Pushes samples into the ring. A bulk load waits for room when the GUI falls behind
+// (backpressure), a paced run acts like a live sensor that cannot wait and drops instead.
+static bool publish(Acquisition *a, const RingSample *s, size_t n, bool may_drop) {
+    while (n > 0) {
+        size_t k = ring_push(&a->ring, s, n);
+        if (k > 0) {
+            unsigned long long end = atomic_fetch_add_explicit(&a->delivered, k, memory_order_relaxed) + k;
+            if (INSTRUMENT_COMPILED) mark_push(a, end);
+            if (a->notify) a->notify(a->user_data);
+            s += k;
+            n -= k;
+            continue;
+        }
+        if (stop_requested(a)) return false;
+        if (may_drop) {
+            atomic_fetch_add_explicit(&a->dropped, n, memory_order_relaxed);
+            return true;
+        }
+        atomic_fetch_add_explicit(&a->stalls, 1, memory_order_relaxed);
+        sleep_ms(1);
+    }
+    return true;
+}
+
+static void flush(Publisher *p) {
+    Acquisition *a = p->a;
+    if (p->n == 0) return;
+
+    if (atomic_load(&a->interval_ms) <= 0) {
+        atomic_fetch_add_explicit(&a->produced, p->n, memory_order_relaxed);
+        if (!publish(a, p->batch, p->n, false)) p->stopped = true;
+    } else {
+        // Paced: one reading per interval, a changed interval applies to the next reading
+        for (size_t i = 0; i < p->n && !p->stopped; i++) {
+            atomic_fetch_add_explicit(&a->produced, 1, memory_order_relaxed);
+            if (!publish(a, &p->batch[i], 1, true)) p->stopped = true;
+            pause_ms(a, atomic_load(&a->interval_ms));
+            if (stop_requested(a)) p->stopped = true;
+        }
+    }
+    p->n = 0;
+}
+
+// Queues one reading, returns false once the run should end
+static bool add(Publisher *p, int seq_no, int64_t epoch, double temperature, double humidity, int sensor_id) {
+    if (p->stopped || p->remaining == 0) return false;
+
+    RingSample *s = &p->batch[p->n++];
+    s->epoch = epoch;
+    s->temperature = temperature;
+    s->humidity = humidity;
+    s->seq_no = seq_no;
+    s->sensor_id = sensor_id;
+    p->remaining--;
+    p->taken++;
+
+    if (p->n == ACQUIRE_BATCH || stop_requested(p->a)) flush(p);
+    return !p->stopped && p->remaining > 0;
+}
+
+// Adds every reading of a staging store
+static bool add_store(Publisher *p, const ReadingStore *store) {
+    for (size_t i = 0; i < store->count; i++) {
+        if (!add(p, store_seq_no(store, i), store_epoch(store, i),
+                 store_temperature(store, i), store_humidity(store, i), store_sensor_id(store, i))) return false;
+    }
+    return true;
+}
+
+static AcquireStatus run_random(Publisher *p) {
+    ReadingStore staging;
+    Workload w;
+    size_t total = p->remaining;
+    AcquireStatus status = ACQUIRE_OK;
+
+    if (!workload_init(&w, &p->a->workload)) return ACQUIRE_NO_MEMORY;
+    store_init(&staging);
+    for (size_t first = 0; first < total; first += ACQUIRE_BATCH) {
+        size_t n = total - first < ACQUIRE_BATCH ? total - first : ACQUIRE_BATCH;
+        store_clear(&staging);
+        if (workload_generate(&w, &staging, n) < n) status = ACQUIRE_NO_MEMORY;
+        if (!add_store(p, &staging) || status != ACQUIRE_OK) break;
+    }
+    store_free(&staging);
+    workload_free(&w);
+    return status;
+}
+
+static bool csv_batch(const Reading *batch, int count, void *user_data) {
+    Publisher *p = user_data;
+    for (int i = 0; i < count; i++) {
+        if (!add(p, batch[i].seq_no, batch[i].epoch, batch[i].temperature, batch[i].humidity, batch[i].sensor_id)) return false;
+    }
+    return true;
+}
+
+static AcquireStatus run_csv(Publisher *p, const char *filename) {
+    IngestResult result;
+    uint64_t size;
+    int64_t mtime;
+    bool ok = csv_ingest_file(filename, csv_batch, p, &result);
+
+    // Every line was scanned and every parsed reading taken, even if max was reached on the last one
+    p->complete = (ok || result.stopped) && file_stamp(filename, &size, &mtime) &&
+                  (uint64_t)result.bytes_read == size && p->taken == (size_t)result.rows_read;
+    return ok || result.stopped ? ACQUIRE_OK : ACQUIRE_OPEN_FAILED;  // Stopped: the run ended or was cancelled
+}
+
+static AcquireStatus run_binlog(Publisher *p, const char *filename, const char *source_csv) {
+    BinlogReader r;
+    if (!binlog_open(&r, filename)) {
+        if (!*source_csv || binlog_convert_csv(source_csv, filename) < 0 || !binlog_open(&r, filename)) {
+            return ACQUIRE_OPEN_FAILED;
+        }
+        printf("Converted %s to %s\n", source_csv, filename);
+    }
+
+    // Records are read in place from the mapping
+    for (size_t i = 0; i < r.count; i++) {
+        const BinlogRecord *rec = &r.records[i];
+        if (!add(p, rec->seq_no, rec->epoch, rec->temperature, rec->humidity, rec->sensor_id)) break;
+    }
+    p->complete = p->taken == r.count;
+    binlog_close(&r);
+    return ACQUIRE_OK;
+}
+
+static AcquireStatus run_archive(Publisher *p, const char *filename, const char *source_csv) {
+    ArchiveReader r;
+    if (!archive_open(&r, filename)) {
+        if (!*source_csv || archive_convert_csv(source_csv, filename) < 0 || !archive_open(&r, filename)) {
+            return ACQUIRE_OPEN_FAILED;
+        }
+        printf("Converted %s to %s\n", source_csv, filename);
+    }
+
+    // One block is decoded at a time, so memory use does not grow with the archive
+    ReadingStore staging;
+    store_init(&staging);
+    AcquireStatus status = ACQUIRE_OK;
+    for (size_t b = 0; b < r.block_count; b++) {
+        store_clear(&staging);
+        if (archive_decode_block(&r, b, &staging) < 0) {
+            status = ACQUIRE_NO_MEMORY;
+            break;
+        }
+        if (!add_store(p, &staging)) break;
+    }
+    p->complete = status == ACQUIRE_OK && p->taken == r.header->record_count;
+    store_free(&staging);
+    archive_close(&r);
+    return status;
+}
+
+// Publishes the lines already in the file, then each line as it is appended
+static AcquireStatus run_tail(Publisher *p, const char *filename) {
+    TailReader t;
+    if (!tail_open(&t, filename)) return ACQUIRE_OPEN_FAILED;
+
+    while (!p->stopped && p->remaining > 0 && !stop_requested(p->a)) {
+        if (!tail_poll(&t, csv_batch, p)) break;
+        flush(p);  // New lines are shown now, not when a batch fills up
+        tail_wait(&t, ACQUIRE_STOP_POLL_MS);
+    }
+    tail_close(&t);
+    return ACQUIRE_OK;
+}
+
+static void *acquire_worker(void *arg) {
+    Acquisition *a = arg;
+    Publisher p;
+    memset(&p, 0, sizeof(p));
+    p.a = a;
+    p.remaining = a->max;
+
+    AcquireStatus status = ACQUIRE_OK;
+    if (a->max > 0) {
+        switch (a->source) {
+            case ACQUIRE_RANDOM:  status = run_random(&p); break;
+            case ACQUIRE_CSV:     status = run_csv(&p, a->filename); break;
+            case ACQUIRE_BINLOG:  status = run_binlog(&p, a->filename, a->source_csv); break;
+            case ACQUIRE_ARCHIVE: status = run_archive(&p, a->filename, a->source_csv); break;
+            case ACQUIRE_TAIL:    status = run_tail(&p, a->filename); break;
+        }
+    }
+    flush(&p);
+
+    atomic_store(&a->complete, p.complete && !p.stopped);
+    atomic_store(&a->status, status);
+    atomic_store(&a->done, true);  // Everything pushed before this is visible to the consumer
+    if (a->notify) a->notify(a->user_data);
+    return NULL;
+}
+
+// Starts a run on a new thread, the previous run must have been joined
+bool acquire_start(Acquisition *a, AcquireSource source, const char *filename, const char *source_csv,
+                   size_t max, int interval_ms, AcquireNotifyFn notify, void *user_data) {
+    if (a->running) return false;
+
+    ring_clear(&a->ring);
+    a->source = source;
+    snprintf(a->filename, sizeof(a->filename), "%s", filename ? filename : "");
+    snprintf(a->source_csv, sizeof(a->source_csv), "%s", source_csv ? source_csv : "");
+    a->max = max;
+    a->notify = notify;
+    a->user_data = user_data;
+    atomic_store(&a->interval_ms, interval_ms);
+    atomic_store(&a->stop, false);
+    atomic_store(&a->done, false);
+    atomic_store(&a->complete, false);
+    atomic_store(&a->status, ACQUIRE_OK);
+    atomic_store(&a->produced, 0);
+    atomic_store(&a->delivered, 0);
+    atomic_store(&a->stalls, 0);
+    atomic_store(&a->dropped, 0);
+    atomic_store(&a->mark_head, 0);
+    atomic_store(&a->mark_tail, 0);
+    a->popped = 0;
+
+    if (pthread_create(&a->thread, NULL, acquire_worker, a) != 0) return false;
+    a->running = true;
+    return true;
+}
+
+// Takes effect with the next reading of a paced run
+void acquire_set_interval(Acquisition *a, int interval_ms) {
+    atomic_store(&a->interval_ms, interval_ms);
+}
+
+// Asks the worker to stop without waiting for it
+void acquire_cancel(Acquisition *a) {
+    atomic_store(&a->stop, true);
+}
+
+// Waits for the worker to finish, readings still queued stay in the ring
+void acquire_join(Acquisition *a) {
+    if (!a->running) return;
+    pthread_join(a->thread, NULL);
+    a->running = false;
+}
+
+void acquire_stop(Acquisition *a) {
+    acquire_cancel(a);
+    acquire_join(a);
+}
+
+// Consumer side: takes up to max readings in arrival order
+size_t acquire_pop(Acquisition *a, RingSample *out, size_t max) {
+    size_t n = ring_pop(&a->ring, out, max);
+    a->popped += n;
+    return n;
+}
+
+// Next push whose readings have all been popped, gives its push time.
+// Consumer side, call after the popped readings were handled.
+bool acquire_take_mark(Acquisition *a, uint64_t *pushed_ns) {
+    size_t tail = atomic_load_explicit(&a->mark_tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&a->mark_head, memory_order_acquire)) return false;
+
+    const AcquireMark *m = &a->marks[tail & (ACQUIRE_MARKS - 1)];
+    if (m->end > a->popped) return false;
+    *pushed_ns = m->ns;
+    atomic_store_explicit(&a->mark_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// True once the worker is done and every reading it published has been popped
+bool acquire_finished(Acquisition *a) {
+    return atomic_load(&a->done) && ring_count(&a->ring) == 0;
+}
@@ -0,0 +1,90 @@
+// acquire.h - Declaration of acquire.c functions and structures
+
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ringbuf.h"
+#include "workload.h"
+
+#define ACQUIRE_RING_CAPACITY 65536   // Readings queued between the worker and the GUI
+#define ACQUIRE_BATCH 1024            // Readings published per push in "as fast as possible" mode
+#define ACQUIRE_STOP_POLL_MS 50       // Longest the worker sleeps before checking for a stop request
+#define ACQUIRE_MARKS 1024            // Push times queued for the sample-to-screen probe, a power of two
+
+// Declaration of reading sources the worker can run
+typedef enum {
+    ACQUIRE_RANDOM,                   // Simulated readings
+    ACQUIRE_CSV,                      // CSV file, parsed on the worker
+    ACQUIRE_BINLOG,                   // Binary log, converted from source_csv if missing
+    ACQUIRE_ARCHIVE,                  // Compressed archive, converted from source_csv if missing
+    ACQUIRE_TAIL                      // CSV file another program appends to, followed until stopped
+} AcquireSource;
+
+typedef enum {
+    ACQUIRE_OK,
+    ACQUIRE_OPEN_FAILED,              // Source missing or unreadable
+    ACQUIRE_NO_MEMORY
+} AcquireStatus;
+
+// Declaration of push time stamp: readings up to `end` (delivered count) were pushed at `ns`
+typedef struct {
+    unsigned long long end;
+    uint64_t ns;
+} AcquireMark;
+
+// Called on the worker thread after readings were published, must be thread safe
+typedef void (*AcquireNotifyFn)(void *user_data);
+
+// Declaration of acquisition run. The worker thread is the only producer of ring
+// and the thread that started the run the only consumer. Counters may be read
+// from any thread while the run is going.
+typedef struct {
+    AcquireSource source;
+    char filename[256];
+    char source_csv[256];             // CSV file a missing binary log or archive is converted from
+    size_t max;                       // Readings to deliver at most
+    WorkloadConfig workload;          // Generator settings of ACQUIRE_RANDOM, set before acquire_start()
+    AcquireNotifyFn notify;
+    void *user_data;
+
+    RingBuffer ring;
+    pthread_t thread;
+    bool running;                     // Thread started and not joined yet, owner thread only
+
+    atomic_int interval_ms;           // Pause between readings, 0 = as fast as possible
+    atomic_bool stop;                 // Asks the worker to end the run early
+    atomic_bool done;                 // Set by the worker after its last push
+    atomic_int status;                // AcquireStatus of the run
+    atomic_bool complete;             // Every reading of a file source was delivered (set with done)
+
+    atomic_ullong produced;           // Readings taken from the source
+    atomic_ullong delivered;          // Readings pushed into the ring
+    atomic_ullong stalls;             // Times the worker waited for room (backpressure)
+    atomic_ullong dropped;            // Readings discarded on a full ring (overflow)
+
+    // Push times beside the ring (SPSC as well), a full queue skips marks
+    AcquireMark marks[ACQUIRE_MARKS];
+    atomic_size_t mark_head;
+    atomic_size_t mark_tail;
+    unsigned long long popped;        // Readings popped so far, consumer only
+} Acquisition;
+
+// Declaration of required functions
+bool acquire_init(Acquisition *a, size_t ring_capacity);
+void acquire_free(Acquisition *a);
+bool acquire_start(Acquisition *a, AcquireSource source, const char *filename, const char *source_csv,
+                   size_t max, int interval_ms, AcquireNotifyFn notify, void *user_data);
+void acquire_set_interval(Acquisition *a, int interval_ms);
+void acquire_cancel(Acquisition *a);
+void acquire_join(Acquisition *a);
+void acquire_stop(Acquisition *a);
+size_t acquire_pop(Acquisition *a, RingSample *out, size_t max);
+bool acquire_take_mark(Acquisition *a, uint64_t *pushed_ns);
+bool acquire_finished(Acquisition *a);
+
+#endif
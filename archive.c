@@ -0,0 +1,494 @@
+// archive.c - Compressed Sensor Archive Module
+
+#include "archive.h"
+#include "ingest.h"
+#include "store.h"
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(ArchiveHeader) == 24, "header layout changed");
+_Static_assert(sizeof(ArchiveBlockInfo) == 64, "block info layout changed");
+_Static_assert(sizeof(ArchiveFooter) == 16, "footer layout changed");
+
+// XOR coder state for one channel
+typedef struct {
+    uint64_t prev;
+    int lead;    // Leading zeros of the current window (-1 = no window yet)
+    int trail;   // Trailing zeros of the current window
+} XorState;
+
+// Delta-of-delta coder state for one integer column
+typedef struct {
+    int64_t prev;
+    int64_t prev_delta;
+} DodState;
+
+static uint64_t double_bits(double v) {
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+static double bits_double(uint64_t u) {
+    double v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+// ---- Bit output ----
+
+static bool bw_reserve(BitWriter *w, size_t extra) {
+    if (w->bytes + extra <= w->capacity) return true;
+    size_t capacity = w->capacity ? w->capacity * 2 : 4096;
+    while (capacity < w->bytes + extra) capacity *= 2;
+    uint8_t *data = realloc(w->data, capacity);
+    if (!data) return false;
+    w->data = data;
+    w->capacity = capacity;
+    return true;
+}
+
+// Appends the low n bits of v, most significant bit first (n <= 64)
+static void put_bits(BitWriter *w, uint64_t v, int n) {
+    if (n > 32) {
+        put_bits(w, v >> 32, n - 32);
+        n = 32;
+    }
+    w->acc = (w->acc << n) | (v & ((1ULL << n) - 1));
+    w->pending += n;
+    while (w->pending >= 8) {
+        w->pending -= 8;
+        w->data[w->bytes++] = (uint8_t)(w->acc >> w->pending);
+    }
+}
+
+static void bw_flush(BitWriter *w) {
+    if (w->pending > 0) {
+        w->data[w->bytes++] = (uint8_t)(w->acc << (8 - w->pending));
+        w->pending = 0;
+    }
+}
+
+// ---- Bit input ----
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;   // In bits
+} BitReader;
+
+static uint64_t get_bits(BitReader *r, int n) {
+    uint64_t v = 0;
+    while (n > 0) {
+        size_t byte = r->pos >> 3;
+        int avail = 8 - (int)(r->pos & 7);
+        int take = n < avail ? n : avail;
+        unsigned b = byte < r->len ? r->data[byte] : 0;  // Reads past the end yield zeros
+        v = (v << take) | ((b >> (avail - take)) & ((1u << take) - 1));
+        r->pos += (size_t)take;
+        n -= take;
+    }
+    return v;
+}
+
+// ---- Delta-of-delta coding (timestamps, seq_no) ----
+
+static void put_dod(BitWriter *w, DodState *s, int64_t value) {
+    int64_t delta = value - s->prev;
+    int64_t dod = delta - s->prev_delta;
+    s->prev = value;
+    s->prev_delta = delta;
+
+    if (dod == 0) {
+        put_bits(w, 0x0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        put_bits(w, 0x2, 2);
+        put_bits(w, (uint64_t)(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        put_bits(w, 0x6, 3);
+        put_bits(w, (uint64_t)(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        put_bits(w, 0xE, 4);
+        put_bits(w, (uint64_t)(dod + 2047), 12);
+    } else {
+        put_bits(w, 0xF, 4);
+        put_bits(w, (uint64_t)dod, 64);
+    }
+}
+
+static int64_t get_dod(BitReader *r, DodState *s) {
+    int64_t dod;
+    if (get_bits(r, 1) == 0) {
+        dod = 0;
+    } else if (get_bits(r, 1) == 0) {
+        dod = (int64_t)get_bits(r, 7) - 63;
+    } else if (get_bits(r, 1) == 0) {
+        dod = (int64_t)get_bits(r, 9) - 255;
+    } else if (get_bits(r, 1) == 0) {
+        dod = (int64_t)get_bits(r, 12) - 2047;
+    } else {
+        dod = (int64_t)get_bits(r, 64);
+    }
+
+    s->prev_delta += dod;
+    s->prev += s->prev_delta;
+    return s->prev;
+}
+
+// ---- XOR coding (temperature, humidity) ----
+
+static void put_xor(BitWriter *w, XorState *s, double value) {
+    uint64_t bits = double_bits(value);
+    uint64_t x = bits ^ s->prev;
+    s->prev = bits;
+
+    if (x == 0) {
+        put_bits(w, 0, 1);  // Same value as before, the common case for slow sensors
+        return;
+    }
+    put_bits(w, 1, 1);
+
+    int lead = __builtin_clzll(x);
+    int trail = __builtin_ctzll(x);
+    if (lead > 31) lead = 31;  // Stored in 5 bits
+
+    if (s->lead >= 0 && lead >= s->lead && trail >= s->trail) {
+        // Meaningful bits fit in the previous window
+        put_bits(w, 0, 1);
+        put_bits(w, x >> s->trail, 64 - s->lead - s->trail);
+    } else {
+        int sig = 64 - lead - trail;
+        put_bits(w, 1, 1);
+        put_bits(w, (uint64_t)lead, 5);
+        put_bits(w, (uint64_t)(sig & 63), 6);  // 64 is stored as 0
+        put_bits(w, x >> trail, sig);
+        s->lead = lead;
+        s->trail = trail;
+    }
+}
+
+static double get_xor(BitReader *r, XorState *s) {
+    if (get_bits(r, 1) == 1) {
+        if (get_bits(r, 1) == 1) {
+            s->lead = (int)get_bits(r, 5);
+            int sig = (int)get_bits(r, 6);
+            if (sig == 0) sig = 64;
+            s->trail = 64 - s->lead - sig;
+        }
+        int sig = 64 - s->lead - s->trail;
+        s->prev ^= get_bits(r, sig) << s->trail;
+    }
+    return bits_double(s->prev);
+}
+
+// ---- Sensor id coding ----
+
+// 0 = same sensor as the previous row, 10 + 8 bits = small change, 11 + 32 bits = any id.
+// Logs of one sensor, or of sensors reporting in runs, cost about a bit per row.
+static void put_sensor(BitWriter *w, int32_t *prev, int32_t id) {
+    int64_t delta = (int64_t)id - *prev;
+    *prev = id;
+    if (delta == 0) {
+        put_bits(w, 0x0, 1);
+    } else if (delta >= -127 && delta <= 128) {
+        put_bits(w, 0x2, 2);
+        put_bits(w, (uint64_t)(delta + 127), 8);
+    } else {
+        put_bits(w, 0x3, 2);
+        put_bits(w, (uint64_t)(uint32_t)id, 32);
+    }
+}
+
+static int32_t get_sensor(BitReader *r, int32_t *prev) {
+    if (get_bits(r, 1) == 1) {
+        if (get_bits(r, 1) == 0) *prev += (int32_t)get_bits(r, 8) - 127;
+        else *prev = (int32_t)(uint32_t)get_bits(r, 32);
+    }
+    return *prev;
+}
+
+// ---- Blocks ----
+
+// Encodes one block, the first row is stored raw so the block decodes on its own
+static void encode_block(BitWriter *w, const int64_t *epoch, const double *temp,
+                         const double *humid, const int *seq, const int *sensor, size_t n) {
+    DodState ts = { epoch[0], 0 }, ss = { seq[0], 0 };
+    XorState tx = { double_bits(temp[0]), -1, 0 }, hx = { double_bits(humid[0]), -1, 0 };
+    int32_t id = sensor[0];
+
+    put_bits(w, (uint64_t)epoch[0], 64);
+    put_bits(w, (uint64_t)(uint32_t)seq[0], 32);
+    put_bits(w, tx.prev, 64);
+    put_bits(w, hx.prev, 64);
+    put_bits(w, (uint64_t)(uint32_t)id, 32);
+
+    for (size_t i = 1; i < n; i++) {
+        put_dod(w, &ts, epoch[i]);
+        put_dod(w, &ss, seq[i]);
+        put_xor(w, &tx, temp[i]);
+        put_xor(w, &hx, humid[i]);
+        put_sensor(w, &id, sensor[i]);
+    }
+    bw_flush(w);
+}
+
+static void decode_block(const uint8_t *data, size_t bytes, size_t n, int64_t *epoch,
+                         double *temp, double *humid, int *seq, int *sensor) {
+    BitReader r = { data, bytes, 0 };
+
+    DodState ts = { (int64_t)get_bits(&r, 64), 0 };
+    DodState ss = { (int32_t)(uint32_t)get_bits(&r, 32), 0 };
+    XorState tx = { get_bits(&r, 64), -1, 0 };
+    XorState hx = { get_bits(&r, 64), -1, 0 };
+    int32_t id = (int32_t)(uint32_t)get_bits(&r, 32);
+
+    epoch[0] = ts.prev;
+    seq[0] = (int)ss.prev;
+    temp[0] = bits_double(tx.prev);
+    humid[0] = bits_double(hx.prev);
+    sensor[0] = id;
+
+    for (size_t i = 1; i < n; i++) {
+        epoch[i] = get_dod(&r, &ts);
+        seq[i] = (int)get_dod(&r, &ss);
+        temp[i] = get_xor(&r, &tx);
+        humid[i] = get_xor(&r, &hx);
+        sensor[i] = get_sensor(&r, &id);
+    }
+}
+
+// ---- Writer ----
+
+ArchiveWriter *archive_writer_open(const char *filename) {
+    ArchiveWriter *w = calloc(1, sizeof(ArchiveWriter));
+    if (!w) return NULL;
+
+    w->file = fopen(filename, "wb");
+    if (!w->file) {
+        free(w);
+        return NULL;
+    }
+
+    memcpy(w->header.magic, ARCHIVE_MAGIC, 4);
+    w->header.version = ARCHIVE_VERSION;
+    w->header.block_size = ARCHIVE_BLOCK_SIZE;
+    w->header.flags = ARCHIVE_SORTED;  // Until a reading goes back in time
+
+    // Placeholder header, rewritten with the final counts on close
+    w->offset = sizeof(ArchiveHeader);
+    if (fwrite(&w->header, sizeof(w->header), 1, w->file) != 1) {
+        fclose(w->file);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+static bool flush_block(ArchiveWriter *w) {
+    if (w->n == 0) return true;
+
+    if (w->header.block_count == w->block_capacity) {
+        size_t capacity = w->block_capacity ? w->block_capacity * 2 : 64;
+        ArchiveBlockInfo *blocks = realloc(w->blocks, capacity * sizeof(ArchiveBlockInfo));
+        if (!blocks) return false;
+        w->blocks = blocks;
+        w->block_capacity = capacity;
+    }
+
+    // Worst case is well under 48 bytes per row
+    w->bits.bytes = 0;
+    if (!bw_reserve(&w->bits, w->n * 48 + 64)) return false;
+    encode_block(&w->bits, w->epoch, w->temperature, w->humidity, w->seq_no, w->sensor_id, w->n);
+    while (w->bits.bytes % 8) w->bits.data[w->bits.bytes++] = 0;  // Keeps the mapped index aligned
+
+    ArchiveBlockInfo *info = &w->blocks[w->header.block_count];
+    info->first_epoch = w->epoch[0];
+    info->last_epoch = w->epoch[w->n - 1];
+    info->offset = w->offset;
+    info->bytes = (uint32_t)w->bits.bytes;
+    info->count = (uint32_t)w->n;
+    info->min_temp = info->max_temp = w->temperature[0];
+    info->min_humid = info->max_humid = w->humidity[0];
+    for (size_t i = 1; i < w->n; i++) {
+        if (w->temperature[i] < info->min_temp) info->min_temp = w->temperature[i];
+        if (w->temperature[i] > info->max_temp) info->max_temp = w->temperature[i];
+        if (w->humidity[i] < info->min_humid) info->min_humid = w->humidity[i];
+        if (w->humidity[i] > info->max_humid) info->max_humid = w->humidity[i];
+    }
+
+    if (fwrite(w->bits.data, 1, w->bits.bytes, w->file) != w->bits.bytes) return false;
+    w->offset += w->bits.bytes;
+    w->header.block_count++;
+    w->header.record_count += w->n;
+    w->n = 0;
+    return true;
+}
+
+bool archive_writer_append(ArchiveWriter *w, int seq_no, int64_t epoch, double temperature, double humidity,
+                           int sensor_id) {
+    int64_t previous = w->n > 0 ? w->epoch[w->n - 1] :
+                       w->header.block_count > 0 ? w->blocks[w->header.block_count - 1].last_epoch : epoch;
+    if (epoch < previous) w->header.flags &= ~ARCHIVE_SORTED;
+    w->epoch[w->n] = epoch;
+    w->sensor_id[w->n] = sensor_id;
+    w->temperature[w->n] = temperature;
+    w->humidity[w->n] = humidity;
+    w->seq_no[w->n] = seq_no;
+    if (++w->n == ARCHIVE_BLOCK_SIZE) return flush_block(w);
+    return true;
+}
+
+// Flushes the last block, writes the block index and footer, frees the writer
+bool archive_writer_close(ArchiveWriter *w) {
+    bool ok = flush_block(w);
+
+    ArchiveFooter footer;
+    footer.index_offset = w->offset;
+    footer.block_count = w->header.block_count;
+    memcpy(footer.magic, ARCHIVE_FOOTER_MAGIC, 4);
+
+    ok = ok && fwrite(w->blocks, sizeof(ArchiveBlockInfo), w->header.block_count, w->file) == w->header.block_count;
+    ok = ok && fwrite(&footer, sizeof(footer), 1, w->file) == 1;
+    ok = ok && fseek(w->file, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&w->header, sizeof(w->header), 1, w->file) == 1;
+    ok = (fclose(w->file) == 0) && ok;
+
+    free(w->bits.data);
+    free(w->blocks);
+    free(w);
+    return ok;
+}
+
+static bool write_batch(const Reading *batch, int count, void *user_data) {
+    ArchiveWriter *w = user_data;
+
+    for (int i = 0; i < count; i++) {
+        if (!archive_writer_append(w, batch[i].seq_no, batch[i].epoch, batch[i].temperature, batch[i].humidity,
+                                   batch[i].sensor_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Converts a CSV log to a compressed archive, returns the readings written or -1 on error
+long long archive_convert_csv(const char *csv_filename, const char *archive_filename) {
+    ArchiveWriter *w = archive_writer_open(archive_filename);
+    IngestResult result;
+    if (!w) return -1;
+
+    bool ok = csv_ingest_file(csv_filename, write_batch, w, &result);
+    long long written = (long long)(w->header.record_count + w->n);
+    ok = archive_writer_close(w) && ok && written == result.rows_read;
+
+    if (!ok) {
+        remove(archive_filename);
+        return -1;
+    }
+    return written;
+}
+
+// ---- Reader ----
+
+// Maps an archive and validates its header and block index, nothing is decoded
+bool archive_open(ArchiveReader *r, const char *filename) {
+    memset(r, 0, sizeof(*r));
+    if (!map_file(filename, &r->mf)) return false;
+
+    const char *data = r->mf.data;
+    size_t size = r->mf.size;
+    if (size < sizeof(ArchiveHeader) + sizeof(ArchiveFooter)) goto invalid;
+
+    const ArchiveHeader *header = (const ArchiveHeader *)data;
+    const ArchiveFooter *footer = (const ArchiveFooter *)(data + size - sizeof(ArchiveFooter));
+    if (memcmp(header->magic, ARCHIVE_MAGIC, 4) != 0) goto invalid;
+    if (header->version != ARCHIVE_VERSION) goto invalid;  // Older archives lack sensor ids, convert again
+    if (header->block_size != ARCHIVE_BLOCK_SIZE) goto invalid;  // Bounds the buffers of archive_decode_block()
+
+    // The block count is bounded by what fits in the file before multiplying, so a
+    // corrupt footer cannot wrap the size check around
+    size_t room = size - sizeof(ArchiveHeader) - sizeof(ArchiveFooter);
+    if (memcmp(footer->magic, ARCHIVE_FOOTER_MAGIC, 4) != 0 ||
+        footer->block_count != header->block_count ||
+        footer->block_count > room / sizeof(ArchiveBlockInfo) ||
+        footer->index_offset < sizeof(ArchiveHeader) ||
+        footer->index_offset != size - sizeof(ArchiveFooter) - footer->block_count * sizeof(ArchiveBlockInfo)) {
+        goto invalid;
+    }
+
+    // Every block lies between the header and the index, and the counts add up
+    const ArchiveBlockInfo *blocks = (const ArchiveBlockInfo *)(data + footer->index_offset);
+    uint64_t records = 0;
+    for (uint32_t b = 0; b < footer->block_count; b++) {
+        if (blocks[b].offset < sizeof(ArchiveHeader) || blocks[b].offset > footer->index_offset ||
+            blocks[b].bytes > footer->index_offset - blocks[b].offset ||
+            blocks[b].count == 0 || blocks[b].count > header->block_size) {
+            goto invalid;
+        }
+        records += blocks[b].count;
+    }
+    if (records != header->record_count) goto invalid;
+
+    r->header = header;
+    r->blocks = blocks;
+    r->block_count = footer->block_count;
+    r->sorted = (header->flags & ARCHIVE_SORTED) != 0;
+    return true;
+
+invalid:
+    unmap_file(&r->mf);
+    return false;
+}
+
+void archive_close(ArchiveReader *r) {
+    unmap_file(&r->mf);
+    memset(r, 0, sizeof(*r));
+}
+
+// Appends every reading of one block to out, returns the number appended or -1
+long long archive_decode_block(const ArchiveReader *r, size_t block, ReadingStore *out) {
+    if (block >= r->block_count) return -1;
+    const ArchiveBlockInfo *info = &r->blocks[block];
+    size_t n = info->count;
+
+    int64_t *epoch = malloc(n * sizeof(int64_t));
+    double *temp = malloc(n * sizeof(double));
+    double *humid = malloc(n * sizeof(double));
+    int *seq = malloc(n * sizeof(int));
+    int *sensor = malloc(n * sizeof(int));
+    long long added = -1;
+
+    if (epoch && temp && humid && seq && sensor) {
+        decode_block((const uint8_t *)r->mf.data + info->offset, info->bytes, n, epoch, temp, humid, seq, sensor);
+        added = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!store_append_sensor(out, seq[i], epoch[i], temp[i], humid[i], sensor[i])) {
+                added = -1;
+                break;
+            }
+            added++;
+        }
+    }
+
+    free(epoch);
+    free(temp);
+    free(humid);
+    free(seq);
+    free(sensor);
+    return added;
+}
+
+// First block that can hold a reading at or after epoch, block_count if none. In a
+// sorted archive a range query decodes from here until a block starts after its end;
+// in any other every block may hold readings in range and the answer is 0.
+size_t archive_find_block(const ArchiveReader *r, int64_t epoch) {
+    if (!r->sorted) return 0;
+
+    size_t lo = 0, hi = r->block_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (r->blocks[mid].last_epoch < epoch) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
@@ -0,0 +1,99 @@
+// archive.h - Declaration of archive.c functions and structures
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "platform.h"
+#include "simulator.h"
+
+// Compressed archive layout (little-endian, native struct layout):
+//   ArchiveHeader | block x block_count | ArchiveBlockInfo x block_count | ArchiveFooter
+// Every block holds up to ARCHIVE_BLOCK_SIZE readings and decodes on its own:
+// timestamps and seq_no use delta-of-delta coding, temperature and humidity use
+// Gorilla style XOR coding against the previous value, and the sensor id costs one
+// bit while it stays the same as on the previous row.
+
+#define ARCHIVE_MAGIC "THLZ"
+#define ARCHIVE_FOOTER_MAGIC "THZF"
+#define ARCHIVE_VERSION 2            // Version 1 had no sensor column and is not read
+#define ARCHIVE_BLOCK_SIZE 4096
+#define ARCHIVE_SORTED 1u            // flags: epochs never decrease, so seeks may use the block index
+
+typedef struct {
+    char magic[4];           // ARCHIVE_MAGIC
+    uint16_t version;        // ARCHIVE_VERSION
+    uint16_t flags;          // ARCHIVE_SORTED, 0 in archives written before it existed
+    uint32_t block_size;     // Readings per full block
+    uint32_t block_count;
+    uint64_t record_count;
+} ArchiveHeader;
+
+// Per-block summary kept in the footer, lets queries skip blocks without decoding
+typedef struct {
+    int64_t first_epoch;
+    int64_t last_epoch;
+    uint64_t offset;         // Byte offset of the encoded block
+    uint32_t bytes;          // Encoded size
+    uint32_t count;          // Readings in the block
+    double min_temp, max_temp;
+    double min_humid, max_humid;
+} ArchiveBlockInfo;
+
+typedef struct {
+    uint64_t index_offset;   // Byte offset of the first ArchiveBlockInfo
+    uint32_t block_count;
+    char magic[4];           // ARCHIVE_FOOTER_MAGIC
+} ArchiveFooter;
+
+// Declaration of growable output buffer for the bit encoder
+typedef struct {
+    uint8_t *data;
+    size_t bytes;
+    size_t capacity;
+    uint64_t acc;            // Bits not yet written out
+    int pending;             // Number of valid bits in acc
+} BitWriter;
+
+// Declaration of streaming archive writer
+typedef struct {
+    FILE *file;
+    ArchiveHeader header;
+    uint64_t offset;                     // Bytes written so far
+    size_t n;                            // Readings buffered for the current block
+    int64_t epoch[ARCHIVE_BLOCK_SIZE];
+    double temperature[ARCHIVE_BLOCK_SIZE];
+    double humidity[ARCHIVE_BLOCK_SIZE];
+    int seq_no[ARCHIVE_BLOCK_SIZE];
+    int sensor_id[ARCHIVE_BLOCK_SIZE];
+    ArchiveBlockInfo *blocks;
+    size_t block_capacity;
+    BitWriter bits;
+} ArchiveWriter;
+
+// Declaration of memory-mapped archive reader
+typedef struct {
+    MappedFile mf;
+    const ArchiveHeader *header;
+    const ArchiveBlockInfo *blocks;
+    size_t block_count;
+    bool sorted;                         // Readings are in time order (ARCHIVE_SORTED)
+} ArchiveReader;
+
+// Declaration of required functions
+ArchiveWriter *archive_writer_open(const char *filename);
+bool archive_writer_append(ArchiveWriter *w, int seq_no, int64_t epoch, double temperature, double humidity,
+                           int sensor_id);
+bool archive_writer_close(ArchiveWriter *w);
+
+bool archive_open(ArchiveReader *r, const char *filename);
+void archive_close(ArchiveReader *r);
+long long archive_decode_block(const ArchiveReader *r, size_t block, ReadingStore *out);
+size_t archive_find_block(const ArchiveReader *r, int64_t epoch);
+
+long long archive_convert_csv(const char *csv_filename, const char *archive_filename);
+
+#endif
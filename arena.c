@@ -0,0 +1,145 @@
+// arena.c - Arena Allocator and Fixed-Point Formatting Module
+
+#include "arena.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FORMAT_FIXED_LIMIT 1e15               // Larger values go through snprintf
+#define EXACT_INTEGER_LIMIT 9007199254740992.0 // 2^53
+
+static const double scale_f[FORMAT_FIXED_MAX_DECIMALS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+static const uint64_t scale_u[FORMAT_FIXED_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+void arena_init(Arena *a) {
+    memset(a, 0, sizeof(*a));
+}
+
+// Releases every block and leaves the arena empty
+void arena_free(Arena *a) {
+    ArenaBlock *b = a->first;
+    while (b) {
+        ArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena_init(a);
+}
+
+// Forgets every allocation but keeps the blocks for the next ones
+void arena_reset(Arena *a) {
+    a->current = a->first;
+    a->used = 0;
+    a->total = 0;
+}
+
+static inline char *block_data(ArenaBlock *b) {
+    return (char *)(b + 1);
+}
+
+// Returns size bytes aligned to ARENA_ALIGN, or NULL when out of memory
+void *arena_alloc(Arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (a->current && a->current->size - a->used >= size) {
+        char *p = block_data(a->current) + a->used;
+        a->used += size;
+        a->total += size;
+        return p;
+    }
+
+    // Move on to the block kept from before the last reset, or link a new one in
+    ArenaBlock *next = a->current ? a->current->next : a->first;
+    if (!next || next->size < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        ArenaBlock *b = malloc(sizeof(ArenaBlock) + block_size);
+        if (!b) return NULL;
+        b->size = block_size;
+        b->next = next;
+        if (a->current) a->current->next = b;
+        else a->first = b;
+        next = b;
+    }
+    a->current = next;
+    a->used = size;
+    a->total += size;
+    return block_data(next);
+}
+
+char *arena_strdup(Arena *a, const char *text) {
+    size_t len = strlen(text) + 1;
+    char *copy = arena_alloc(a, len);
+    if (copy) memcpy(copy, text, len);
+    return copy;
+}
+
+// Writes value with a fixed number of decimals, the same text as snprintf("%.*f")
+// (rounded half to even on the exact binary value) without going through printf.
+// Returns the length, like snprintf.
+size_t format_fixed(double value, int decimals, char *out, size_t size) {
+    double magnitude = fabs(value);
+    double scaled = 0.0;
+    bool fast = decimals >= 0 && decimals <= FORMAT_FIXED_MAX_DECIMALS && size >= FORMAT_FIXED_LEN &&
+                magnitude < FORMAT_FIXED_LIMIT;  // Also false for NaN
+    if (fast) {
+        scaled = magnitude * scale_f[decimals];
+        fast = scaled < EXACT_INTEGER_LIMIT;
+    }
+    if (!fast) {
+        int len = snprintf(out, size, "%.*f", decimals, value);
+        return len < 0 ? 0 : (size_t)len;
+    }
+
+    // scaled - whole is exact and so is subtracting 0.5 from it whenever the result
+    // is near 0. Only near a tie can the rounding of the product matter; fma gives
+    // its exact error there.
+    double whole = floor(scaled);
+    double half = (scaled - whole) - 0.5;
+    if (fabs(half) <= scaled * DBL_EPSILON) half += fma(magnitude, scale_f[decimals], -scaled);
+    uint64_t n = (uint64_t)whole;
+    if (half > 0 || (half == 0 && (n & 1))) n++;
+
+    // Digits backwards into a scratch buffer: decimals, point, integer part
+    char digits[FORMAT_FIXED_LEN];
+    char *p = digits + sizeof(digits);
+    uint64_t integer = n / scale_u[decimals];
+    uint64_t fraction = n % scale_u[decimals];
+    for (int i = 0; i < decimals; i++) {
+        *--p = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    if (decimals > 0) *--p = '.';
+    do {
+        *--p = (char)('0' + integer % 10);
+        integer /= 10;
+    } while (integer);
+    if (signbit(value)) *--p = '-';  // printf keeps the sign of -0.001 and -0.0 as well
+
+    size_t len = (size_t)(digits + sizeof(digits) - p);
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return len;
+}
+
+// format_fixed() followed by suffix, as a string allocated from the arena
+char *arena_format_fixed(Arena *a, double value, int decimals, const char *suffix) {
+    char digits[FORMAT_FIXED_LEN];
+    size_t len = format_fixed(value, decimals, digits, sizeof(digits));
+    size_t suffix_len = strlen(suffix);
+    char *text = arena_alloc(a, len + suffix_len + 1);
+    if (!text) return NULL;
+
+    if (len < sizeof(digits)) {
+        memcpy(text, digits, len);
+        memcpy(text + len, suffix, suffix_len + 1);
+    } else {
+        snprintf(text, len + suffix_len + 1, "%.*f%s", decimals, value, suffix);  // Did not fit, rare
+    }
+    return text;
+}
@@ -0,0 +1,39 @@
+// arena.h - Declaration of arena.c functions and structures
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64u << 10)   // Bytes per block, bigger requests get a block of their own
+#define ARENA_ALIGN 8
+#define FORMAT_FIXED_MAX_DECIMALS 9
+#define FORMAT_FIXED_LEN 32            // Buffer size for format_fixed() of values below 1e15
+
+// Declaration of one arena block, its bytes follow the header
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+} ArenaBlock;
+
+// Declaration of bump allocator. Allocations are never freed one by one: a reset
+// forgets all of them at once and keeps the blocks, so a reused arena stops calling
+// malloc once it has grown to its working size.
+typedef struct {
+    ArenaBlock *first;
+    ArenaBlock *current;
+    size_t used;                       // Bytes taken from the current block
+    size_t total;                      // Bytes handed out since the last reset
+} Arena;
+
+// Declaration of required functions
+void arena_init(Arena *a);
+void arena_free(Arena *a);
+void arena_reset(Arena *a);
+void *arena_alloc(Arena *a, size_t size);
+char *arena_strdup(Arena *a, const char *text);
+size_t format_fixed(double value, int decimals, char *out, size_t size);
+char *arena_format_fixed(Arena *a, double value, int decimals, const char *suffix);
+
+#endif
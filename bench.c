@@ -0,0 +1,379 @@
+// bench.c - Benchmark Program for the ingest, statistics and table hot paths
+
+#include <gtk/gtk.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simulator.h"
+#include "stats.h"
+#include "store.h"
+#include "reading_model.h"
+#include "workload.h"
+#include "platform.h"
+#include "rules.h"
+#include "loader.h"
+#include "sensors.h"
+
+//gcc -O2 bench.c simulator.c stats.c ingest.c platform.c store.c timestamp.c window.c sensors.c reading_model.c workload.c instrument.c rules.c loader.c arena.c -o bench -pthread $(pkg-config --cflags --libs gtk+-3.0)
+
+#define BENCH_MIN_ROWS 1000              // Smallest dataset, sizes grow by 10x
+#define BENCH_DEFAULT_MAX_ROWS 10000000  // 1e8 needs about 10 GB of memory, ask for it with --max
+#define BENCH_MIN_SECONDS 0.25           // Small sizes are repeated until they run this long
+#define BENCH_CSV_FILE "bench_readings.csv"
+#define BENCH_JSON_FILE "bench.json"
+#define BENCH_CSV_BLOCK 1000000          // Rows generated per block while writing the CSV
+#define BENCH_MAX_RESULTS 64
+#define BENCH_BLOCK 1024                 // Readings per rule evaluation, ACQUIRE_BATCH in main.c
+#define BENCH_SENSORS 1000               // Sensors of the rules case
+#define BENCH_RULES_PER_SENSOR 4         // Rules of each sensor on top of the shared ones
+
+// Declaration of one measured case
+typedef struct {
+    const char *name;
+    size_t rows;
+    int runs;                // Repetitions averaged into seconds
+    double seconds;          // Time of one run
+    size_t peak_rss;         // Process high-water mark after the case
+    bool skipped;            // Not enough memory for this size
+} BenchResult;
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static int result_count = 0;
+
+static const char *temp_status_text[] = {
+    "Safe Temperature levels.", "Warning! Safe Temperature exceeding.", "Alert! Safe Temperature exceeded."
+};
+static const char *humid_status_text[] = {
+    "Safe Humidity levels.", "Warning! Safe Humidity exceeding.", "Alert! Safe Humidity exceeded."
+};
+
+// Records a case and prints its human readable line
+static void report(const char *name, size_t rows, int runs, double seconds, bool skipped) {
+    BenchResult *r = &results[result_count < BENCH_MAX_RESULTS ? result_count++ : BENCH_MAX_RESULTS - 1];
+    r->name = name;
+    r->rows = rows;
+    r->runs = runs;
+    r->seconds = seconds;
+    r->peak_rss = peak_rss_bytes();
+    r->skipped = skipped;
+
+    if (skipped) {
+        printf("%-26s %11zu rows   skipped (out of memory)\n", name, rows);
+    } else {
+        printf("%-26s %11zu rows %10.4f s %14.0f rows/s %9.2f ns/row %9.1f MiB peak\n",
+               name, rows, seconds, rows / seconds, seconds * 1e9 / rows, r->peak_rss / 1048576.0);
+    }
+    fflush(stdout);
+}
+
+// Writes rows readings to a CSV file in blocks, so memory does not grow with the file
+static bool write_bench_csv(const char *filename, size_t rows) {
+    FILE *f = fopen(filename, "w");
+    if (!f) return false;
+
+    WorkloadConfig cfg;
+    Workload w;
+    ReadingStore block;
+    workload_defaults(&cfg);
+    if (!workload_init(&w, &cfg)) {
+        fclose(f);
+        return false;
+    }
+    store_init(&block);
+
+    fprintf(f, "seq_no,timestamp,temperature,humidity\n");
+    for (size_t done = 0; done < rows; done += block.count) {
+        size_t n = rows - done < BENCH_CSV_BLOCK ? rows - done : BENCH_CSV_BLOCK;
+        store_clear(&block);
+        if (workload_generate(&w, &block, n) < n) break;
+        for (size_t i = 0; i < block.count; i++) {
+            Reading r;
+            store_get(&block, i, &r);
+            fprintf(f, "%d,%s,%.2f,%.2f\n", r.seq_no, r.timestamp, r.temperature, r.humidity);
+        }
+    }
+
+    store_free(&block);
+    workload_free(&w);
+    return fclose(f) == 0;
+}
+
+// Per-reading work of the GUI drain (process_readings() in main.c): per-sensor status
+// window, rules, live statistics overall and per sensor, and a model row. This is
+// what update_gui() shows, minus the widgets.
+static bool populate_model(const ReadingStore *store, size_t rows, double *seconds) {
+    static SensorShard *shards[BENCH_BLOCK];
+    static int sensor_ids[BENCH_BLOCK];
+    static int64_t epochs[BENCH_BLOCK];
+    static double status_temp[BENCH_BLOCK], status_humid[BENCH_BLOCK];
+    static AlertLevel temp_levels[BENCH_BLOCK], humid_levels[BENCH_BLOCK];
+    SensorSet sensors;
+    RunningStats live;
+    RuleEngine rules;
+    sensors_init(&sensors, STATUS_WINDOW_SIZE);
+    running_stats_reset(&live);
+    rules_init(&rules);
+    if (!rules_defaults(&rules) || !rules_compile(&rules)) {
+        rules_free(&rules);
+        return false;
+    }
+    ReadingModel *model = reading_model_new(store, temp_status_text, humid_status_text);
+
+    bool complete = true;
+    double start = monotonic_seconds();
+    for (size_t first = 0; first < rows && complete; first += BENCH_BLOCK) {
+        size_t n = rows - first < BENCH_BLOCK ? rows - first : BENCH_BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            epochs[i] = store_epoch(store, first + i);
+            sensor_ids[i] = store_sensor_id(store, first + i);
+            shards[i] = sensors_get(&sensors, sensor_ids[i]);
+            sensors_status(shards[i], epochs[i], store_temperature(store, first + i), store_humidity(store, first + i),
+                           &status_temp[i], &status_humid[i]);
+        }
+        rules_eval(&rules, sensor_ids, epochs, status_temp, status_humid, temp_levels, humid_levels, n);
+        for (size_t i = 0; i < n && complete; i++) {
+            double temperature = store_temperature(store, first + i);
+            double humidity = store_humidity(store, first + i);
+            running_stats_add(&live, epochs[i], temperature, humidity, temp_levels[i], humid_levels[i]);
+            if (shards[i]) {
+                running_stats_add(&shards[i]->stats, epochs[i], temperature, humidity, temp_levels[i], humid_levels[i]);
+                complete = sensors_add(shards[i], store, first + i);
+            }
+            complete = complete && reading_model_append(model, temp_levels[i], humid_levels[i]);
+        }
+    }
+    *seconds = monotonic_seconds() - start;
+
+    complete = reading_model_rows(model) == rows;
+    g_object_unref(model);
+    rules_free(&rules);
+    sensors_free(&sensors);
+    return complete;
+}
+
+// Rules alone over readings spread across BENCH_SENSORS sensors, each with
+// BENCH_RULES_PER_SENSOR rules of its own (range, rate, sustained, hysteresis)
+// next to the built-in ones
+static bool evaluate_rules(const ReadingStore *store, size_t rows, double *seconds) {
+    static int sensor_ids[BENCH_BLOCK];
+    static int64_t epochs[BENCH_BLOCK];
+    static double temperature[BENCH_BLOCK], humidity[BENCH_BLOCK];
+    static AlertLevel temp_levels[BENCH_BLOCK], humid_levels[BENCH_BLOCK];
+    RuleEngine rules;
+    rules_init(&rules);
+    bool ok = rules_defaults(&rules);
+    for (int id = 0; id < BENCH_SENSORS && ok; id++) {
+        Rule own[BENCH_RULES_PER_SENSOR] = {
+            { id, RULE_TEMP, RULE_VALUE, RULE_LT, 5.0 + id % 7, LEVEL_WARNING, 1, 0.5 },
+            { id, RULE_TEMP, RULE_RATE, RULE_GT, 0.5, LEVEL_ALERT, 3, 0.1 },
+            { id, RULE_HUMID, RULE_VALUE, RULE_GE, 70.0 + id % 5, LEVEL_ALERT, 5, 1.0 },
+            { id, RULE_HUMID, RULE_RATE, RULE_LT, -0.5, LEVEL_WARNING, 2, 0.0 },
+        };
+        for (int r = 0; r < BENCH_RULES_PER_SENSOR && ok; r++) ok = rules_add(&rules, &own[r]);
+    }
+    ok = ok && rules_compile(&rules);
+
+    double start = monotonic_seconds();
+    for (size_t first = 0; first < rows && ok; first += BENCH_BLOCK) {
+        size_t n = rows - first < BENCH_BLOCK ? rows - first : BENCH_BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            sensor_ids[i] = (int)((first + i) % BENCH_SENSORS);
+            epochs[i] = store_epoch(store, first + i);
+            temperature[i] = store_temperature(store, first + i);
+            humidity[i] = store_humidity(store, first + i);
+        }
+        ok = rules_eval(&rules, sensor_ids, epochs, temperature, humidity, temp_levels, humid_levels, n);
+    }
+    *seconds = monotonic_seconds() - start;
+    rules_free(&rules);
+    return ok;
+}
+
+// Formats every cell the table shows, the cost of drawing each row once
+static bool render_model(const ReadingStore *store, size_t rows, double *seconds) {
+    ReadingModel *model = reading_model_new(store, temp_status_text, humid_status_text);
+    for (size_t i = 0; i < rows; i++) {
+        if (!reading_model_append(model, LEVEL_SAFE, LEVEL_SAFE)) break;
+    }
+    bool complete = reading_model_rows(model) == rows;
+
+    double start = monotonic_seconds();
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &iter);
+    while (complete && valid) {
+        int seq_no, sensor_id;
+        gchar *timestamp, *temperature, *humidity, *temp_status, *humid_status;
+        gtk_tree_model_get(GTK_TREE_MODEL(model), &iter,
+                           READING_COL_SEQ, &seq_no, READING_COL_SENSOR, &sensor_id,
+                           READING_COL_TIMESTAMP, &timestamp, READING_COL_TEMPERATURE, &temperature,
+                           READING_COL_HUMIDITY, &humidity, READING_COL_TEMP_STATUS, &temp_status,
+                           READING_COL_HUMID_STATUS, &humid_status, -1);
+        g_free(timestamp);
+        g_free(temperature);
+        g_free(humidity);
+        g_free(temp_status);
+        g_free(humid_status);
+        valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter);
+    }
+    *seconds = monotonic_seconds() - start;
+
+    g_object_unref(model);
+    return complete;
+}
+
+// Runs every case for one dataset size
+static void bench_size(size_t n) {
+    int runs;
+    double start, elapsed;
+    Statistics stats;
+
+    Reading *readings = malloc(sizeof(Reading) * n);
+    if (!readings) {
+        report("generate_random_readings", n, 0, 0, true);
+        report("read_csv_readings", n, 0, 0, true);
+        report("calc_statistics", n, 0, 0, true);
+    } else {
+        runs = 0;
+        start = monotonic_seconds();
+        do {
+            generate_random_readings(readings, (int)n);
+            runs++;
+        } while ((elapsed = monotonic_seconds() - start) < BENCH_MIN_SECONDS);
+        report("generate_random_readings", n, runs, elapsed / runs, false);
+
+        runs = 0;
+        int loaded = 0;
+        start = monotonic_seconds();
+        do {
+            loaded = read_csv_readings(BENCH_CSV_FILE, readings, (int)n);
+            runs++;
+        } while ((elapsed = monotonic_seconds() - start) < BENCH_MIN_SECONDS && loaded >= 0);
+        if (loaded != (int)n) {
+            printf("read_csv_readings loaded %d of %zu rows\n", loaded, n);
+        }
+        report("read_csv_readings", n, runs, elapsed / runs, false);
+
+        runs = 0;
+        start = monotonic_seconds();
+        do {
+            calc_statistics(readings, (int)n, &stats);
+            runs++;
+        } while ((elapsed = monotonic_seconds() - start) < BENCH_MIN_SECONDS);
+        report("calc_statistics", n, runs, elapsed / runs, false);
+        free(readings);
+    }
+
+    // The table cases read from a store, as the application does
+    ReadingStore store;
+    WorkloadConfig cfg;
+    Workload w;
+    store_init(&store);
+    workload_defaults(&cfg);
+    bool filled = workload_init(&w, &cfg) && workload_generate(&w, &store, n) == n;
+    workload_free(&w);
+
+    double seconds = 0, total = 0;
+    bool ok = filled;
+    for (runs = 0; ok && (runs == 0 || total < BENCH_MIN_SECONDS); runs++) {
+        ok = populate_model(&store, n, &seconds);
+        total += seconds;
+    }
+    report("model_populate", n, runs, ok ? total / runs : 0, !ok);
+
+    total = 0;
+    ok = filled;
+    for (runs = 0; ok && (runs == 0 || total < BENCH_MIN_SECONDS); runs++) {
+        ok = evaluate_rules(&store, n, &seconds);
+        total += seconds;
+    }
+    report("rules_eval", n, runs, ok ? total / runs : 0, !ok);
+
+    total = 0;
+    ok = filled;
+    for (runs = 0; ok && (runs == 0 || total < BENCH_MIN_SECONDS); runs++) {
+        ok = render_model(&store, n, &seconds);
+        total += seconds;
+    }
+    report("model_render", n, runs, ok ? total / runs : 0, !ok);
+    store_free(&store);
+}
+
+// The whole CSV through the parallel loader, on one thread and on every CPU
+static void bench_loader(size_t rows) {
+    const char *files[1] = { BENCH_CSV_FILE };
+    int threads[2] = { 1, 0 };
+    const char *names[2] = { "load_csv_files_1_thread", "load_csv_files" };
+
+    for (int t = 0; t < 2; t++) {
+        ReadingStore store;
+        LoaderResult result;
+        store_init(&store);
+        long long loaded = load_csv_files(files, 1, threads[t], &store, &result);
+        report(names[t], rows, 1, result.seconds, loaded != (long long)rows);
+        store_free(&store);
+    }
+}
+
+// Machine readable copy of the results, for comparing versions
+static bool write_json(const char *filename, size_t max_rows) {
+    FILE *f = fopen(filename, "w");
+    if (!f) return false;
+
+    fprintf(f, "{\n  \"time\": %lld,\n  \"max_rows\": %zu,\n  \"cpus\": %d,\n  \"stats_kernel\": \"%s\",\n  \"results\": [\n",
+            (long long)time(NULL), max_rows, cpu_count(), stats_kernel_name());
+    for (int i = 0; i < result_count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(f, "    {\"case\": \"%s\", \"rows\": %zu, ", r->name, r->rows);
+        if (r->skipped) {
+            fprintf(f, "\"skipped\": true, \"peak_rss_bytes\": %zu}", r->peak_rss);
+        } else {
+            fprintf(f, "\"runs\": %d, \"seconds\": %.9f, \"rows_per_sec\": %.1f, \"ns_per_row\": %.3f, \"peak_rss_bytes\": %zu}",
+                    r->runs, r->seconds, r->rows / r->seconds, r->seconds * 1e9 / r->rows, r->peak_rss);
+        }
+        fprintf(f, "%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    size_t max_rows = BENCH_DEFAULT_MAX_ROWS;
+    const char *json_file = BENCH_JSON_FILE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_rows = (size_t)strtod(argv[++i], NULL);  // Accepts 1e8
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file = argv[++i];
+        } else {
+            printf("Usage: %s [--max ROWS] [--json FILE]\n", argv[0]);
+            printf("Times the hot paths for 1e3, 1e4, ... up to ROWS readings (default %d)\n",
+                   BENCH_DEFAULT_MAX_ROWS);
+            return 1;
+        }
+    }
+    if (max_rows < BENCH_MIN_ROWS) max_rows = BENCH_MIN_ROWS;
+    if (max_rows > INT_MAX) max_rows = INT_MAX;  // The Reading array APIs count in int
+
+    printf("Writing %zu rows to %s...\n", max_rows, BENCH_CSV_FILE);
+    if (!write_bench_csv(BENCH_CSV_FILE, max_rows)) {
+        printf("Error: cannot write %s\n", BENCH_CSV_FILE);
+        return 1;
+    }
+
+    printf("%-26s %16s %12s %21s %16s %18s\n", "case", "size", "time/run", "throughput", "per row", "peak RSS");
+    for (size_t n = BENCH_MIN_ROWS; n <= max_rows; n *= 10) {
+        bench_size(n);
+    }
+    bench_loader(max_rows);
+    remove(BENCH_CSV_FILE);
+
+    if (!write_json(json_file, max_rows)) {
+        printf("Error: cannot write %s\n", json_file);
+        return 1;
+    }
+    printf("Results written to %s\n", json_file);
+    return 0;
+}
@@ -0,0 +1,193 @@
+// binlog.c - Binary Log Format Module
+
+#include "binlog.h"
+#include "ingest.h"
+#include "store.h"
+#include "timestamp.h"
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(BinlogHeader) == 40, "header layout changed");
+_Static_assert(sizeof(BinlogRecord) == 32, "record layout changed");
+_Static_assert(sizeof(BinlogFooter) == 24, "footer layout changed");
+
+bool binlog_writer_open(BinlogWriter *w, const char *filename) {
+    memset(w, 0, sizeof(*w));
+    w->file = fopen(filename, "wb");
+    if (!w->file) return false;
+
+    memcpy(w->header.magic, BINLOG_MAGIC, 4);
+    w->header.version = BINLOG_VERSION;
+    w->header.record_size = sizeof(BinlogRecord);
+    w->header.flags = BINLOG_SORTED;  // Until a record goes back in time
+
+    // Placeholder header, rewritten with the final counts on close
+    return fwrite(&w->header, sizeof(w->header), 1, w->file) == 1;
+}
+
+bool binlog_writer_append(BinlogWriter *w, int seq_no, int64_t epoch, double temperature, double humidity,
+                          int sensor_id) {
+    BinlogRecord rec = { epoch, temperature, humidity, seq_no, sensor_id };
+
+    if (w->header.record_count % BINLOG_INDEX_STRIDE == 0) {
+        if (w->index_count == w->index_capacity) {
+            size_t capacity = w->index_capacity ? w->index_capacity * 2 : 64;
+            BinlogIndexEntry *index = realloc(w->index, capacity * sizeof(BinlogIndexEntry));
+            if (!index) return false;
+            w->index = index;
+            w->index_capacity = capacity;
+        }
+        w->index[w->index_count].epoch = epoch;
+        w->index[w->index_count].record = w->header.record_count;
+        w->index_count++;
+    }
+
+    if (fwrite(&rec, sizeof(rec), 1, w->file) != 1) return false;
+    if (w->header.record_count > 0 && epoch < w->header.last_epoch) w->header.flags &= ~BINLOG_SORTED;
+    if (w->header.record_count == 0) w->header.first_epoch = epoch;
+    w->header.last_epoch = epoch;
+    w->header.record_count++;
+    return true;
+}
+
+// Writes the index and footer, patches the header and closes the file
+bool binlog_writer_close(BinlogWriter *w) {
+    if (!w->file) return false;
+
+    BinlogFooter footer;
+    footer.index_offset = sizeof(BinlogHeader) + w->header.record_count * sizeof(BinlogRecord);
+    footer.index_count = w->index_count;
+    footer.index_stride = BINLOG_INDEX_STRIDE;
+    memcpy(footer.magic, BINLOG_FOOTER_MAGIC, 4);
+
+    bool ok = fwrite(w->index, sizeof(BinlogIndexEntry), w->index_count, w->file) == w->index_count;
+    ok = ok && fwrite(&footer, sizeof(footer), 1, w->file) == 1;
+    ok = ok && fseek(w->file, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&w->header, sizeof(w->header), 1, w->file) == 1;
+    ok = (fclose(w->file) == 0) && ok;
+
+    free(w->index);
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+// Maps a binary log and validates its header and footer, no records are parsed
+bool binlog_open(BinlogReader *r, const char *filename) {
+    memset(r, 0, sizeof(*r));
+    if (!map_file(filename, &r->mf)) return false;
+
+    const char *data = r->mf.data;
+    size_t size = r->mf.size;
+    if (size < sizeof(BinlogHeader) + sizeof(BinlogFooter)) goto invalid;
+
+    const BinlogHeader *header = (const BinlogHeader *)data;
+    if (memcmp(header->magic, BINLOG_MAGIC, 4) != 0 || header->version != BINLOG_VERSION ||
+        header->record_size != sizeof(BinlogRecord)) {
+        goto invalid;
+    }
+
+    // Counts are bounded by what fits in the file before multiplying, so a corrupt
+    // header cannot overflow the size checks below
+    const BinlogFooter *footer = (const BinlogFooter *)(data + size - sizeof(BinlogFooter));
+    size_t room = size - sizeof(BinlogHeader) - sizeof(BinlogFooter);
+    if (header->record_count > room / sizeof(BinlogRecord)) goto invalid;
+    uint64_t records_end = sizeof(BinlogHeader) + header->record_count * sizeof(BinlogRecord);
+    room -= (size_t)header->record_count * sizeof(BinlogRecord);
+    if (footer->index_count > room / sizeof(BinlogIndexEntry)) goto invalid;
+    if (memcmp(footer->magic, BINLOG_FOOTER_MAGIC, 4) != 0 ||
+        footer->index_offset != records_end ||
+        footer->index_stride != BINLOG_INDEX_STRIDE ||
+        records_end + footer->index_count * sizeof(BinlogIndexEntry) + sizeof(BinlogFooter) != size) {
+        goto invalid;  // Truncated or not closed properly
+    }
+
+    // The index is trusted by binlog_find_epoch(), so it must be exactly what the writer
+    // produces: one entry per stride, pointing at that record and holding its epoch
+    const BinlogRecord *records = (const BinlogRecord *)(data + sizeof(BinlogHeader));
+    const BinlogIndexEntry *index = (const BinlogIndexEntry *)(data + footer->index_offset);
+    if (footer->index_count != (header->record_count + BINLOG_INDEX_STRIDE - 1) / BINLOG_INDEX_STRIDE) goto invalid;
+    for (uint64_t i = 0; i < footer->index_count; i++) {
+        uint64_t record = i * BINLOG_INDEX_STRIDE;
+        if (index[i].record != record || index[i].epoch != records[record].epoch) goto invalid;
+    }
+
+    r->header = header;
+    r->records = records;
+    r->count = (size_t)header->record_count;
+    r->index = index;
+    r->index_count = (size_t)footer->index_count;
+    r->sorted = (header->flags & BINLOG_SORTED) != 0;
+    return true;
+
+invalid:
+    unmap_file(&r->mf);
+    return false;
+}
+
+void binlog_close(BinlogReader *r) {
+    unmap_file(&r->mf);
+    memset(r, 0, sizeof(*r));
+}
+
+// Index of the first record with epoch >= the given one. Only a sorted log can be
+// searched, in any other any record may be in range and the answer is 0.
+size_t binlog_find_epoch(const BinlogReader *r, int64_t epoch) {
+    if (!r->sorted) return 0;
+
+    // Sparse index narrows the search to one stride of records
+    size_t lo = 0, hi = r->index_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (r->index[mid].epoch < epoch) lo = mid + 1;
+        else hi = mid;
+    }
+
+    size_t first = lo > 0 ? (size_t)r->index[lo - 1].record : 0;
+    size_t last = lo < r->index_count ? (size_t)r->index[lo].record : r->count;
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (r->records[mid].epoch < epoch) first = mid + 1;
+        else last = mid;
+    }
+    return first;
+}
+
+// Adapter for the Reading based APIs
+void binlog_get(const BinlogReader *r, size_t i, Reading *out) {
+    const BinlogRecord *rec = &r->records[i];
+    out->seq_no = rec->seq_no;
+    out->epoch = rec->epoch;
+    timestamp_format(rec->epoch, out->timestamp);
+    out->temperature = rec->temperature;
+    out->humidity = rec->humidity;
+    out->sensor_id = rec->sensor_id;
+}
+
+static bool write_batch(const Reading *batch, int count, void *user_data) {
+    BinlogWriter *w = user_data;
+
+    for (int i = 0; i < count; i++) {
+        if (!binlog_writer_append(w, batch[i].seq_no, batch[i].epoch, batch[i].temperature, batch[i].humidity,
+                                  batch[i].sensor_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Converts a CSV log to the binary format, returns the records written or -1 on error
+long long binlog_convert_csv(const char *csv_filename, const char *bin_filename) {
+    BinlogWriter w;
+    IngestResult result;
+
+    if (!binlog_writer_open(&w, bin_filename)) return -1;
+    bool ok = csv_ingest_file(csv_filename, write_batch, &w, &result);
+    long long written = (long long)w.header.record_count;
+    ok = binlog_writer_close(&w) && ok && written == result.rows_read;
+
+    if (!ok) {
+        remove(bin_filename);  // Never leave a half written log behind
+        return -1;
+    }
+    return written;
+}
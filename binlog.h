@@ -0,0 +1,87 @@
+// binlog.h - Declaration of binlog.c functions and structures
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "platform.h"
+#include "simulator.h"
+
+// Binary log layout (little-endian, native struct layout):
+//   BinlogHeader | BinlogRecord x record_count | BinlogIndexEntry x index_count | BinlogFooter
+// The index holds the epoch of every BINLOG_INDEX_STRIDE-th record.
+
+#define BINLOG_MAGIC "THLB"
+#define BINLOG_FOOTER_MAGIC "THLF"
+#define BINLOG_VERSION 2            // Version 1 had no flags and is not read
+#define BINLOG_INDEX_STRIDE 4096
+#define BINLOG_SORTED 1u            // flags: epochs never decrease, so seeks may use the index
+
+typedef struct {
+    char magic[4];           // BINLOG_MAGIC
+    uint16_t version;        // BINLOG_VERSION
+    uint16_t record_size;    // sizeof(BinlogRecord), lets readers reject foreign layouts
+    uint32_t flags;          // BINLOG_SORTED
+    uint32_t reserved;
+    uint64_t record_count;
+    int64_t first_epoch;     // Epoch of the first and last record (0 when empty)
+    int64_t last_epoch;
+} BinlogHeader;
+
+typedef struct {
+    int64_t epoch;           // Wall-clock seconds, see timestamp.h
+    double temperature;
+    double humidity;
+    int32_t seq_no;
+    int32_t sensor_id;       // 0 for single-sensor logs (the reserved field of early version 1 files)
+} BinlogRecord;
+
+typedef struct {
+    int64_t epoch;           // Epoch of record number `record`
+    uint64_t record;
+} BinlogIndexEntry;
+
+typedef struct {
+    uint64_t index_offset;   // Byte offset of the first index entry
+    uint64_t index_count;
+    uint32_t index_stride;
+    char magic[4];           // BINLOG_FOOTER_MAGIC
+} BinlogFooter;
+
+// Declaration of streaming writer
+typedef struct {
+    FILE *file;
+    BinlogHeader header;
+    BinlogIndexEntry *index;
+    size_t index_count;
+    size_t index_capacity;
+} BinlogWriter;
+
+// Declaration of memory-mapped reader, records can be used in place
+typedef struct {
+    MappedFile mf;
+    const BinlogHeader *header;
+    const BinlogRecord *records;
+    size_t count;
+    const BinlogIndexEntry *index;
+    size_t index_count;
+    bool sorted;                      // Records are in time order (BINLOG_SORTED)
+} BinlogReader;
+
+// Declaration of required functions
+bool binlog_writer_open(BinlogWriter *w, const char *filename);
+bool binlog_writer_append(BinlogWriter *w, int seq_no, int64_t epoch, double temperature, double humidity,
+                          int sensor_id);
+bool binlog_writer_close(BinlogWriter *w);
+
+bool binlog_open(BinlogReader *r, const char *filename);
+void binlog_close(BinlogReader *r);
+size_t binlog_find_epoch(const BinlogReader *r, int64_t epoch);
+void binlog_get(const BinlogReader *r, size_t i, Reading *out);
+
+long long binlog_convert_csv(const char *csv_filename, const char *bin_filename);
+
+#endif
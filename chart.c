@@ -0,0 +1,383 @@
+// chart.c - Time-Series Chart Module
+
+#include "chart.h"
+#include "store.h"
+#include "timestamp.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MARGIN_LEFT 44      // Room for the value labels
+#define MARGIN_RIGHT 8
+#define MARGIN_TOP 8
+#define MARGIN_BOTTOM 20    // Room for the time labels
+#define VALUE_PADDING 2.0   // Space above and below the plotted values
+
+static void fold(ChartColumn *col, double t_min, double t_max, double h_min, double h_max, uint64_t count) {
+    if (col->count == 0) {
+        col->temp_min = t_min;
+        col->temp_max = t_max;
+        col->humid_min = h_min;
+        col->humid_max = h_max;
+    } else {
+        if (t_min < col->temp_min) col->temp_min = t_min;
+        if (t_max > col->temp_max) col->temp_max = t_max;
+        if (h_min < col->humid_min) col->humid_min = h_min;
+        if (h_max > col->humid_max) col->humid_max = h_max;
+    }
+    col->count += count;
+}
+
+// Column of a time inside the view
+static inline int column_of(const Chart *c, int64_t epoch) {
+    return (int)((epoch - c->from) * c->width / (c->to - c->from));
+}
+
+// First row at or after epoch, the store must be in time order
+static size_t first_row_at(const ReadingStore *store, int64_t epoch) {
+    size_t lo = 0, hi = store->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store_epoch(store, mid) < epoch) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Value range covering the columns and both thresholds, returns true if it changed
+static bool update_range(Chart *c) {
+    double lo = c->warning, hi = c->alert;
+    for (int i = 0; i < c->width; i++) {
+        const ChartColumn *col = &c->columns[i];
+        if (col->count == 0) continue;
+        lo = fmin(lo, fmin(col->temp_min, col->humid_min));
+        hi = fmax(hi, fmax(col->temp_max, col->humid_max));
+    }
+    lo = floor(lo - VALUE_PADDING);
+    hi = ceil(hi + VALUE_PADDING);
+    bool changed = lo != c->y_min || hi != c->y_max;
+    c->y_min = lo;
+    c->y_max = hi;
+    return changed;
+}
+
+// Recomputes every column of the view. A column spanning a minute or more is
+// built from the rollup buckets, so the cost depends on the width, not the readings.
+static void rebuild(Chart *c) {
+    const ReadingStore *s = c->store;
+    c->folded = s->count;
+    if (c->width < 1) return;
+    memset(c->columns, 0, sizeof(ChartColumn) * (size_t)c->width);
+    if (!c->has_view) {
+        update_range(c);
+        return;
+    }
+
+    double per_column = (double)(c->to - c->from) / c->width;
+    if (per_column >= rollup_seconds(ROLLUP_MINUTE) && c->rollup && c->rollup->source_count == s->count) {
+        // Coarsest level whose buckets still fit in a column
+        RollupLevel level = ROLLUP_MINUTE;
+        while (level + 1 < ROLLUP_LEVELS && rollup_seconds(level + 1) <= per_column) level++;
+
+        size_t n;
+        const RollupBucket *b = rollup_range(c->rollup, level, c->from, c->to - 1, &n);
+        for (size_t i = 0; i < n; i++) {
+            int x = b[i].start < c->from ? 0 : column_of(c, b[i].start);
+            if (x >= c->width || b[i].count == 0) continue;
+            fold(&c->columns[x], b[i].temp.min, b[i].temp.max, b[i].humid.min, b[i].humid.max, b[i].count);
+        }
+    } else {
+        for (size_t i = c->sorted ? first_row_at(s, c->from) : 0; i < s->count; i++) {
+            int64_t epoch = store_epoch(s, i);
+            if (epoch >= c->to) {
+                if (c->sorted) break;
+                continue;
+            }
+            if (epoch < c->from) continue;
+            double t = store_temperature(s, i), h = store_humidity(s, i);
+            fold(&c->columns[column_of(c, epoch)], t, t, h, h, 1);
+        }
+    }
+    update_range(c);
+}
+
+static void set_color(cairo_t *cr, int channel) {
+    if (channel == 0) cairo_set_source_rgb(cr, 0.80, 0.20, 0.10);  // Temperature
+    else cairo_set_source_rgb(cr, 0.10, 0.40, 0.80);                // Humidity
+}
+
+static inline double y_of(const Chart *c, double value, double plot_height) {
+    return MARGIN_TOP + (c->y_max - value) / (c->y_max - c->y_min) * plot_height;
+}
+
+// Draws the columns inside [first, end) of one channel as a vertical min/max stroke
+// per column, joined to the next column
+static void draw_channel(cairo_t *cr, const Chart *c, int channel, int first, int end, double plot_height) {
+    bool started = false;
+    set_color(cr, channel);
+    cairo_set_line_width(cr, 1.0);
+    for (int i = first; i < end; i++) {
+        const ChartColumn *col = &c->columns[i];
+        if (col->count == 0) continue;
+        double lo = channel == 0 ? col->temp_min : col->humid_min;
+        double hi = channel == 0 ? col->temp_max : col->humid_max;
+        double x = MARGIN_LEFT + i + 0.5;
+        if (!started) {
+            cairo_move_to(cr, x, y_of(c, hi, plot_height));
+            started = true;
+        } else {
+            cairo_line_to(cr, x, y_of(c, hi, plot_height));
+        }
+        cairo_line_to(cr, x, y_of(c, lo, plot_height) + 0.01);  // A flat column still shows a dot
+    }
+    cairo_stroke(cr);
+}
+
+static void draw_label(cairo_t *cr, double x, double y, const char *text, bool right_align) {
+    cairo_text_extents_t ext;
+    cairo_text_extents(cr, text, &ext);
+    cairo_move_to(cr, right_align ? x - ext.x_advance : x, y);
+    cairo_show_text(cr, text);
+}
+
+// Redraws the part of the chart inside the clip, so appending readings repaints
+// only the columns they changed
+static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    Chart *c = data;
+    int alloc_width = gtk_widget_get_allocated_width(widget);
+    int alloc_height = gtk_widget_get_allocated_height(widget);
+    int width = alloc_width - MARGIN_LEFT - MARGIN_RIGHT;
+    double plot_height = alloc_height - MARGIN_TOP - MARGIN_BOTTOM;
+    if (width < 1 || plot_height < 1) return FALSE;
+
+    if (width != c->width) {
+        ChartColumn *columns = realloc(c->columns, sizeof(ChartColumn) * (size_t)width);
+        if (!columns) return FALSE;
+        c->columns = columns;
+        c->width = width;
+        rebuild(c);
+    }
+
+    double x1, y1, x2, y2;
+    cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+
+    // Alert band above the alert threshold, warning band between the thresholds
+    double y_alert = y_of(c, c->alert, plot_height), y_warning = y_of(c, c->warning, plot_height);
+    cairo_set_source_rgba(cr, 1.0, 0.0, 0.0, 0.10);
+    cairo_rectangle(cr, MARGIN_LEFT, MARGIN_TOP, width, y_alert - MARGIN_TOP);
+    cairo_fill(cr);
+    cairo_set_source_rgba(cr, 1.0, 0.65, 0.0, 0.12);
+    cairo_rectangle(cr, MARGIN_LEFT, y_alert, width, y_warning - y_alert);
+    cairo_fill(cr);
+
+    cairo_set_source_rgb(cr, 0.6, 0.6, 0.6);
+    cairo_set_line_width(cr, 1.0);
+    cairo_rectangle(cr, MARGIN_LEFT - 0.5, MARGIN_TOP - 0.5, width + 1, plot_height + 1);
+    cairo_stroke(cr);
+
+    // One column of overlap on each side keeps the joins between columns intact
+    int first = (int)floor(x1) - MARGIN_LEFT - 1;
+    int end = (int)ceil(x2) - MARGIN_LEFT + 1;
+    if (first < 0) first = 0;
+    if (end > c->width) end = c->width;
+    if (first < end) {
+        cairo_save(cr);
+        cairo_rectangle(cr, MARGIN_LEFT, MARGIN_TOP, width, plot_height);
+        cairo_clip(cr);
+        draw_channel(cr, c, 0, first, end, plot_height);
+        draw_channel(cr, c, 1, first, end, plot_height);
+        cairo_restore(cr);
+    }
+
+    char text[64];
+    cairo_select_font_face(cr, "sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 10);
+    cairo_set_source_rgb(cr, 0.2, 0.2, 0.2);
+    const double marks[4] = { c->y_max, c->alert, c->warning, c->y_min };
+    for (int i = 0; i < 4; i++) {
+        snprintf(text, sizeof(text), "%.0f", marks[i]);
+        draw_label(cr, MARGIN_LEFT - 4, y_of(c, marks[i], plot_height) + 4, text, true);
+    }
+
+    if (c->has_view) {
+        char ts[TIMESTAMP_LEN];
+        timestamp_format(c->from, ts);
+        draw_label(cr, MARGIN_LEFT, alloc_height - 6, ts, false);
+        timestamp_format(c->to, ts);
+        draw_label(cr, MARGIN_LEFT + width, alloc_height - 6, ts, true);
+    }
+    set_color(cr, 0);
+    draw_label(cr, MARGIN_LEFT + width / 2 - 4, alloc_height - 6, "Temperature", true);
+    set_color(cr, 1);
+    draw_label(cr, MARGIN_LEFT + width / 2 + 4, alloc_height - 6, "Humidity", false);
+    return FALSE;
+}
+
+// Shows every reading again and keeps following new ones
+static void fit_all(Chart *c) {
+    const ReadingStore *s = c->store;
+    c->follow = true;
+    if (s->count == 0) return;
+
+    c->from = store_epoch(s, 0);
+    int64_t span = CHART_INITIAL_SPAN;
+    int64_t last = store_epoch(s, s->count - 1);
+    while (last >= c->from + span) span *= 2;
+    c->to = c->from + span;
+    c->has_view = true;
+}
+
+// Mouse wheel zooms around the pointer
+static gboolean on_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data) {
+    Chart *c = data;
+    double factor;
+    if (!c->has_view || c->width < 1) return FALSE;
+    if (event->direction == GDK_SCROLL_UP) factor = 1.0 / CHART_ZOOM_STEP;
+    else if (event->direction == GDK_SCROLL_DOWN) factor = CHART_ZOOM_STEP;
+    else return FALSE;
+
+    double at = fmin(fmax((event->x - MARGIN_LEFT) / c->width, 0.0), 1.0);
+    double span = (double)(c->to - c->from);
+    double pivot = c->from + at * span;
+    double new_span = fmax(span * factor, CHART_MIN_SPAN);
+    c->from = (int64_t)llround(pivot - at * new_span);
+    c->to = c->from + (int64_t)llround(new_span);
+    c->follow = false;
+    rebuild(c);
+    gtk_widget_queue_draw(widget);
+    return TRUE;
+}
+
+// Dragging pans, a double click goes back to the whole run
+static gboolean on_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+    Chart *c = data;
+    if (event->button != 1) return FALSE;
+    if (event->type == GDK_2BUTTON_PRESS) {
+        c->dragging = false;
+        fit_all(c);
+        rebuild(c);
+        gtk_widget_queue_draw(widget);
+        return TRUE;
+    }
+    c->dragging = true;
+    c->drag_x = event->x;
+    return TRUE;
+}
+
+static gboolean on_button_release(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+    Chart *c = data;
+    if (event->button == 1) c->dragging = false;
+    return FALSE;
+}
+
+static gboolean on_motion(GtkWidget *widget, GdkEventMotion *event, gpointer data) {
+    Chart *c = data;
+    if (!c->dragging || !c->has_view || c->width < 1) return FALSE;
+
+    int64_t shift = (int64_t)llround((c->drag_x - event->x) * (double)(c->to - c->from) / c->width);
+    if (shift == 0) return TRUE;
+    c->from += shift;
+    c->to += shift;
+    c->drag_x = event->x;
+    c->follow = false;
+    rebuild(c);
+    gtk_widget_queue_draw(widget);
+    return TRUE;
+}
+
+// Creates the drawing area, the store and rollup must outlive the chart
+GtkWidget *chart_init(Chart *chart, const ReadingStore *store, const Rollup *rollup,
+                      double warning, double alert) {
+    memset(chart, 0, sizeof(*chart));
+    chart->store = store;
+    chart->rollup = rollup;
+    chart->warning = warning;
+    chart->alert = alert;
+    chart->follow = true;
+    chart->sorted = true;
+    update_range(chart);
+
+    chart->area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(chart->area, -1, CHART_HEIGHT);
+    gtk_widget_add_events(chart->area, GDK_SCROLL_MASK | GDK_BUTTON_PRESS_MASK |
+                                       GDK_BUTTON_RELEASE_MASK | GDK_BUTTON1_MOTION_MASK);
+    g_signal_connect(chart->area, "draw", G_CALLBACK(on_draw), chart);
+    g_signal_connect(chart->area, "scroll-event", G_CALLBACK(on_scroll), chart);
+    g_signal_connect(chart->area, "button-press-event", G_CALLBACK(on_button_press), chart);
+    g_signal_connect(chart->area, "button-release-event", G_CALLBACK(on_button_release), chart);
+    g_signal_connect(chart->area, "motion-notify-event", G_CALLBACK(on_motion), chart);
+    return chart->area;
+}
+
+void chart_free(Chart *chart) {
+    free(chart->columns);
+    chart->columns = NULL;
+    chart->width = 0;
+}
+
+// Forgets the view for a new run, the store has been cleared
+void chart_reset(Chart *chart) {
+    chart->has_view = false;
+    chart->follow = true;
+    chart->sorted = true;
+    chart->folded = 0;
+    if (chart->width > 0) memset(chart->columns, 0, sizeof(ChartColumn) * (size_t)chart->width);
+    update_range(chart);
+    if (chart->area) gtk_widget_queue_draw(chart->area);
+}
+
+void chart_set_thresholds(Chart *chart, double warning, double alert) {
+    chart->warning = warning;
+    chart->alert = alert;
+    update_range(chart);
+    if (chart->area) gtk_widget_queue_draw(chart->area);
+}
+
+// Adds the readings appended to the store since the last call. Only the columns
+// they land in are repainted, unless the view has to grow or rescale.
+void chart_append(Chart *c) {
+    const ReadingStore *s = c->store;
+    size_t first = c->folded;
+    if (s->count <= first) return;
+
+    for (size_t i = first > 0 ? first : 1; i < s->count && c->sorted; i++) {
+        if (store_epoch(s, i) < store_epoch(s, i - 1)) c->sorted = false;
+    }
+
+    // Following: double the span whenever a reading passes the right edge, so the
+    // columns are rebuilt only a logarithmic number of times
+    if (!c->has_view || (c->follow && store_epoch(s, s->count - 1) >= c->to)) {
+        fit_all(c);
+        if (c->width > 0) rebuild(c);
+        gtk_widget_queue_draw(c->area);
+        return;
+    }
+    if (c->width < 1) {
+        c->folded = s->count;
+        return;
+    }
+
+    int lo = c->width, hi = -1;
+    for (size_t i = first; i < s->count; i++) {
+        int64_t epoch = store_epoch(s, i);
+        if (epoch < c->from || epoch >= c->to) continue;
+        double t = store_temperature(s, i), h = store_humidity(s, i);
+        int x = column_of(c, epoch);
+        fold(&c->columns[x], t, t, h, h, 1);
+        if (x < lo) lo = x;
+        if (x > hi) hi = x;
+    }
+    c->folded = s->count;
+    if (hi < lo) return;  // Nothing visible changed
+
+    if (update_range(c)) {
+        gtk_widget_queue_draw(c->area);
+    } else {
+        // The stroke joins neighbours, so one column on each side is repainted too
+        gtk_widget_queue_draw_area(c->area, MARGIN_LEFT + lo - 1, 0, hi - lo + 3,
+                                   gtk_widget_get_allocated_height(c->area));
+    }
+}
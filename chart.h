@@ -0,0 +1,56 @@
+// chart.h - Declaration of chart.c functions and structures
+
+#ifndef CHART_H
+#define CHART_H
+
+#include <gtk/gtk.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+#include "rollup.h"
+
+#define CHART_HEIGHT 220               // Requested height in pixels
+#define CHART_INITIAL_SPAN 86400       // Seconds shown when the first reading arrives
+#define CHART_MIN_SPAN 60              // Narrowest zoom in seconds
+#define CHART_ZOOM_STEP 1.25           // Span factor per scroll step
+
+// Declaration of one pixel column: extremes of every reading that falls into it
+typedef struct {
+    double temp_min, temp_max;
+    double humid_min, humid_max;
+    uint64_t count;
+} ChartColumn;
+
+// Declaration of time-series chart over a ReadingStore. Readings are decimated to
+// one min/max pair per channel and pixel column, so drawing costs the same for
+// any number of readings.
+typedef struct {
+    GtkWidget *area;                   // GtkDrawingArea the chart draws into
+    const ReadingStore *store;
+    const Rollup *rollup;              // Aggregates used when a column spans a minute or more
+    double warning, alert;             // Threshold bands
+
+    int64_t from, to;                  // Visible time range [from, to)
+    bool has_view;                     // Range set, false until the first reading
+    bool follow;                       // Grow the range to keep every reading in view
+    bool sorted;                       // Epochs seen so far are non-decreasing
+
+    ChartColumn *columns;              // One per plot column
+    int width;                         // Plot columns (pixels)
+    size_t folded;                     // Readings reflected in columns
+    double y_min, y_max;               // Value range of the plot
+
+    bool dragging;
+    double drag_x;                     // Pointer x at the last drag event
+} Chart;
+
+// Declaration of required functions
+GtkWidget *chart_init(Chart *chart, const ReadingStore *store, const Rollup *rollup,
+                      double warning, double alert);
+void chart_free(Chart *chart);
+void chart_reset(Chart *chart);
+void chart_append(Chart *c);
+void chart_set_thresholds(Chart *chart, double warning, double alert);
+
+#endif
@@ -0,0 +1,347 @@
+// check.c - Automated Round-Trip and Ordering Checks (no GTK)
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simulator.h"
+#include "store.h"
+#include "timestamp.h"
+#include "binlog.h"
+#include "archive.h"
+#include "ringbuf.h"
+#include "loader.h"
+
+//gcc -O2 check.c ingest.c platform.c store.c timestamp.c binlog.c archive.c ringbuf.c loader.c instrument.c -o check -pthread -lm
+
+#define CHECK_ROWS 10000                 // Spans three archive blocks and three binlog index strides
+#define CHECK_RING_CAPACITY 1024         // Small, so the producer keeps running into a full ring
+#define CHECK_RING_SAMPLES 1000000
+#define CHECK_LOADER_BIG_ROWS 200000     // Larger than LOADER_CHUNK_BYTES, so it is split into pieces
+#define CHECK_BIN_FILE "check_readings.bin"
+#define CHECK_ARCHIVE_FILE "check_readings.thz"
+
+static int failures = 0;
+
+static void report(const char *name, bool ok, const char *detail) {
+    if (ok) {
+        printf("PASS %s\n", name);
+    } else {
+        printf("FAIL %s: %s\n", name, detail);
+        failures++;
+    }
+}
+
+// Deterministic test data, the same for every run
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+// Readings both formats have to give back exactly: irregular gaps (repeats, jumps of
+// a day and back in time), negative and large values, and sensor ids that repeat,
+// move a little, and jump across the whole int range
+typedef struct {
+    int64_t epoch[CHECK_ROWS];
+    double temperature[CHECK_ROWS];
+    double humidity[CHECK_ROWS];
+    int seq_no[CHECK_ROWS];
+    int sensor_id[CHECK_ROWS];
+} CheckData;
+
+static CheckData data;
+
+static void make_data(void) {
+    static const int sensors[] = { 0, 1, 2, 7, -5, 100000, 2147483647, -2147483647 - 1 };
+    int64_t epoch = 1740787200;  // 2025-03-01 00:00
+    int sensor = 0;
+
+    for (int i = 0; i < CHECK_ROWS; i++) {
+        uint32_t r = next_random();
+        if (r % 100 == 0) epoch += 86400;
+        else if (r % 100 == 1) epoch -= 30;
+        else if (r % 100 > 10) epoch += 60;
+
+        if (r % 7 == 0) sensor = sensors[next_random() % 8];
+        data.epoch[i] = epoch;
+        data.temperature[i] = (int)(next_random() % 12000 - 4000) / 100.0;  // -40.00 to 79.99
+        data.humidity[i] = (int)(next_random() % 10001) / 100.0;
+        if (i % 1000 == 999) data.temperature[i] = 1e300;
+        data.seq_no[i] = i;
+        data.sensor_id[i] = sensor;
+    }
+}
+
+// Index of the first mismatching row of a store, -1 if it holds exactly the data
+static long first_difference(const ReadingStore *store) {
+    if (store->count != CHECK_ROWS) return 0;
+    for (size_t i = 0; i < store->count; i++) {
+        if (store_epoch(store, i) != data.epoch[i] || store_temperature(store, i) != data.temperature[i] ||
+            store_humidity(store, i) != data.humidity[i] || store_seq_no(store, i) != data.seq_no[i] ||
+            store_sensor_id(store, i) != data.sensor_id[i]) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+static void check_binlog(void) {
+    BinlogWriter w;
+    bool ok = binlog_writer_open(&w, CHECK_BIN_FILE);
+    for (int i = 0; ok && i < CHECK_ROWS; i++) {
+        ok = binlog_writer_append(&w, data.seq_no[i], data.epoch[i], data.temperature[i], data.humidity[i],
+                                  data.sensor_id[i]);
+    }
+    ok = binlog_writer_close(&w) && ok;
+    report("binlog write", ok, "could not write " CHECK_BIN_FILE);
+
+    BinlogReader r;
+    if (!binlog_open(&r, CHECK_BIN_FILE)) {
+        report("binlog round trip", false, "could not open " CHECK_BIN_FILE);
+        return;
+    }
+    ReadingStore store;
+    store_init(&store);
+    for (size_t i = 0; i < r.count; i++) {
+        const BinlogRecord *rec = &r.records[i];
+        store_append_sensor(&store, rec->seq_no, rec->epoch, rec->temperature, rec->humidity, rec->sensor_id);
+    }
+    char detail[64];
+    long diff = first_difference(&store);
+    snprintf(detail, sizeof(detail), "row %ld differs", diff);
+    report("binlog round trip", diff < 0, detail);
+    report("binlog unsorted", !r.sorted && binlog_find_epoch(&r, data.epoch[CHECK_ROWS - 1]) == 0,
+           "time goes back in the data, but the log is marked sorted");
+    store_free(&store);
+    binlog_close(&r);
+}
+
+// binlog_find_epoch() and archive_find_block() only search files marked sorted
+static void check_seek(void) {
+    BinlogWriter w;
+    ArchiveWriter *aw = archive_writer_open(CHECK_ARCHIVE_FILE);
+    bool ok = binlog_writer_open(&w, CHECK_BIN_FILE) && aw;
+    for (int i = 0; ok && i < CHECK_ROWS; i++) {
+        int64_t epoch = 1740787200 + (int64_t)(i / 2) * 60;  // Two readings per minute
+        ok = binlog_writer_append(&w, i, epoch, 20.0, 50.0, i % 3) &&
+             archive_writer_append(aw, i, epoch, 20.0, 50.0, i % 3);
+    }
+    ok = binlog_writer_close(&w) && ok;
+    if (aw) ok = archive_writer_close(aw) && ok;
+
+    BinlogReader r;
+    ArchiveReader ar;
+    bool opened = ok && binlog_open(&r, CHECK_BIN_FILE);
+    if (opened && !archive_open(&ar, CHECK_ARCHIVE_FILE)) {
+        binlog_close(&r);
+        opened = false;
+    }
+    if (!opened) {
+        report("binlog and archive seek", false, "could not write or open the sorted files");
+        return;
+    }
+
+    char detail[96] = "the files are not marked sorted";
+    bool found = r.sorted && ar.sorted;
+    for (int minute = -1; minute <= CHECK_ROWS / 2 && found; minute += 37) {
+        int64_t epoch = 1740787200 + (int64_t)minute * 60;
+        size_t expected = minute < 0 ? 0 : (size_t)minute * 2;
+        size_t record = binlog_find_epoch(&r, epoch);
+        size_t block = archive_find_block(&ar, epoch);
+        size_t expected_block = expected / ARCHIVE_BLOCK_SIZE;
+        found = record == expected && (expected >= (size_t)CHECK_ROWS ? block == ar.block_count : block == expected_block);
+        if (!found) {
+            snprintf(detail, sizeof(detail), "minute %d: record %zu (expected %zu), block %zu (expected %zu)",
+                     minute, record, expected, block, expected_block);
+        }
+    }
+    report("binlog and archive seek", found, detail);
+    archive_close(&ar);
+    binlog_close(&r);
+}
+
+static void check_archive(void) {
+    ArchiveWriter *w = archive_writer_open(CHECK_ARCHIVE_FILE);
+    bool ok = w != NULL;
+    for (int i = 0; ok && i < CHECK_ROWS; i++) {
+        ok = archive_writer_append(w, data.seq_no[i], data.epoch[i], data.temperature[i], data.humidity[i],
+                                   data.sensor_id[i]);
+    }
+    if (w) ok = archive_writer_close(w) && ok;
+    report("archive write", ok, "could not write " CHECK_ARCHIVE_FILE);
+
+    ArchiveReader r;
+    if (!archive_open(&r, CHECK_ARCHIVE_FILE)) {
+        report("archive round trip", false, "could not open " CHECK_ARCHIVE_FILE);
+        return;
+    }
+    ReadingStore store;
+    store_init(&store);
+    bool decoded = true;
+    for (size_t b = 0; b < r.block_count && decoded; b++) decoded = archive_decode_block(&r, b, &store) >= 0;
+    char detail[64];
+    long diff = decoded ? first_difference(&store) : 0;
+    snprintf(detail, sizeof(detail), decoded ? "row %ld differs" : "block decode failed", diff);
+    report("archive round trip", decoded && diff < 0, detail);
+    report("archive block count", r.block_count == (CHECK_ROWS + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE,
+           "unexpected number of blocks");
+    report("archive unsorted", !r.sorted && archive_find_block(&r, data.epoch[CHECK_ROWS - 1]) == 0,
+           "time goes back in the data, but the archive is marked sorted");
+    store_free(&store);
+    archive_close(&r);
+}
+
+// ---- Ring ----
+
+typedef struct {
+    RingBuffer ring;
+    atomic_bool finished;                // Set by the producer after its last push
+} RingCheck;
+
+static RingSample ring_sample(size_t i) {
+    RingSample s;
+    s.epoch = (int64_t)i * 3;
+    s.temperature = (double)i * 0.5;
+    s.humidity = (double)(i % 100);
+    s.seq_no = (int32_t)i;
+    s.sensor_id = (int32_t)(i % 7);
+    return s;
+}
+
+// Producer: batches of 1 to 300 samples, pushing the rest again when the ring is full
+static void *ring_producer(void *arg) {
+    RingCheck *rc = arg;
+    RingSample batch[300];
+    uint32_t state = 99;
+    size_t produced = 0;
+
+    while (produced < CHECK_RING_SAMPLES) {
+        state = state * 1664525u + 1013904223u;
+        size_t n = 1 + (state >> 8) % 300;
+        if (n > CHECK_RING_SAMPLES - produced) n = CHECK_RING_SAMPLES - produced;
+        for (size_t i = 0; i < n; i++) batch[i] = ring_sample(produced + i);
+
+        size_t pushed = 0;
+        while (pushed < n) {
+            size_t k = ring_push(&rc->ring, batch + pushed, n - pushed);
+            if (k == 0) sched_yield();  // Full, the consumer may share this CPU
+            pushed += k;
+        }
+        produced += n;
+    }
+    atomic_store(&rc->finished, true);
+    return NULL;
+}
+
+// Every sample arrives once, in order and intact, while both threads run flat out
+static void check_ring(void) {
+    static RingCheck rc;
+    if (!ring_init(&rc.ring, CHECK_RING_CAPACITY)) {
+        report("ring order", false, "out of memory");
+        return;
+    }
+    atomic_store(&rc.finished, false);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ring_producer, &rc) != 0) {
+        report("ring order", false, "could not start the producer");
+        ring_free(&rc.ring);
+        return;
+    }
+
+    RingSample out[257];
+    size_t received = 0;
+    bool ordered = true;
+    while (received < CHECK_RING_SAMPLES && ordered) {
+        size_t n = ring_pop(&rc.ring, out, 1 + received % 257);
+        if (n == 0) sched_yield();
+        for (size_t i = 0; i < n && ordered; i++) {
+            RingSample expected = ring_sample(received + i);
+            ordered = memcmp(&out[i], &expected, sizeof(RingSample)) == 0;
+        }
+        received += n;
+    }
+    if (!ordered) {
+        // Let the producer finish so it can be joined
+        while (ring_pop(&rc.ring, out, 257) > 0 || !atomic_load(&rc.finished)) sched_yield();
+    }
+    pthread_join(thread, NULL);
+
+    char detail[64];
+    snprintf(detail, sizeof(detail), "sample near %zu out of order or damaged", received);
+    report("ring order", ordered && ring_count(&rc.ring) == 0, detail);
+    ring_free(&rc.ring);
+}
+
+// ---- Loader ----
+
+// CSV of rows readings, the n-th at start + n * step seconds
+static bool write_csv(const char *filename, size_t rows, int64_t start, int64_t step, int sensor_id) {
+    FILE *f = fopen(filename, "w");
+    if (!f) return false;
+    fprintf(f, "seq_no,timestamp,temperature,humidity,sensor_id\n");
+    for (size_t i = 0; i < rows; i++) {
+        char ts[TIMESTAMP_LEN];
+        timestamp_format(start + (int64_t)i * step, ts);
+        fprintf(f, "%zu,%s,%.2f,%.2f,%d\n", i, ts, 20.0 + (double)(i % 500) / 100.0, 50.0, sensor_id);
+    }
+    return fclose(f) == 0;
+}
+
+// Files that overlap in time (interleaved minutes) and one split into pieces must come
+// out as one log in time order, with every row exactly once
+static void check_loader(void) {
+    const char *files[] = { "check_loader_a.csv", "check_loader_b.csv", "check_loader_c.csv" };
+    int64_t base = 1740787200;
+    bool written = write_csv(files[0], 5000, base, 120, 1) &&                     // Even minutes
+                   write_csv(files[1], 5000, base + 60, 120, 2) &&                // Odd minutes
+                   write_csv(files[2], CHECK_LOADER_BIG_ROWS, base - 86400 * 30, 1, 3);  // Month before, by second
+    if (!written) {
+        report("loader order", false, "could not write the input files");
+    } else {
+        for (int threads = 1; threads <= 4; threads *= 2) {
+            ReadingStore store;
+            LoaderResult result;
+            store_init(&store);
+            long long loaded = load_csv_files(files, 3, threads, &store, &result);
+
+            size_t expected = 5000 + 5000 + CHECK_LOADER_BIG_ROWS;
+            long long seq_sum[4] = { 0, 0, 0, 0 };
+            bool ordered = loaded == (long long)expected && store.count == expected;
+            for (size_t i = 1; i < store.count && ordered; i++) ordered = store_epoch(&store, i - 1) < store_epoch(&store, i);
+            for (size_t i = 0; i < store.count && ordered; i++) {
+                int sensor = store_sensor_id(&store, i);
+                ordered = sensor >= 1 && sensor <= 3;
+                if (ordered) seq_sum[sensor] += store_seq_no(&store, i);
+            }
+            ordered = ordered && seq_sum[1] == 5000LL * 4999 / 2 && seq_sum[2] == 5000LL * 4999 / 2 &&
+                      seq_sum[3] == (long long)CHECK_LOADER_BIG_ROWS * (CHECK_LOADER_BIG_ROWS - 1) / 2;
+
+            char name[32], detail[96];
+            snprintf(name, sizeof(name), "loader order (%d thread%s)", threads, threads > 1 ? "s" : "");
+            snprintf(detail, sizeof(detail), "%lld readings of %zu, %lld tasks", loaded, expected, result.tasks);
+            report(name, ordered && result.tasks > 3, detail);  // More tasks than files: the big one was split
+            store_free(&store);
+        }
+    }
+    for (int i = 0; i < 3; i++) remove(files[i]);
+}
+
+int main(void) {
+    make_data();
+    check_binlog();
+    check_archive();
+    check_seek();
+    check_ring();
+    check_loader();
+    remove(CHECK_BIN_FILE);
+    remove(CHECK_ARCHIVE_FILE);
+
+    if (failures > 0) printf("%d check%s failed\n", failures, failures > 1 ? "s" : "");
+    else printf("All checks passed\n");
+    return failures > 0 ? 1 : 0;
+}
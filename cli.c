@@ -0,0 +1,467 @@
+// cli.c - Headless Batch Analysis Program (no GTK)
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simulator.h"
+#include "stats.h"
+#include "store.h"
+#include "ingest.h"
+#include "binlog.h"
+#include "archive.h"
+#include "rules.h"
+#include "loader.h"
+#include "sensors.h"
+#include "timestamp.h"
+
+//gcc -O2 cli.c stats.c ingest.c platform.c store.c timestamp.c binlog.c archive.c rules.c instrument.c loader.c sensors.c window.c -o cli -pthread -lm
+
+#define CLI_BLOCK 4096          // Readings per rule evaluation (INGEST_BATCH_SIZE)
+#define CLI_MAX_PATH 1024       // Longest file name read from a --list file
+#define CLI_MAX_STATUS_WINDOW 100  // Same limit as the GUI spinner
+
+typedef enum {
+    FORMAT_CSV,
+    FORMAT_JSON
+} OutputFormat;
+
+// Declaration of the analysis of one file. Readings are streamed through the
+// rules and the running statistics, nothing is kept per reading, so memory use
+// does not depend on the file size.
+typedef struct {
+    RunningStats stats;
+    RuleEngine *rules;
+    int64_t from, to;         // Readings outside [from, to] are left out
+    SensorSet sensors;        // Status windows per sensor, as in the GUI
+    size_t status_window;
+    long long skipped;        // Lines or records that could not be used
+    size_t n;                 // Readings buffered for the rules
+    int sensor_ids[CLI_BLOCK];
+    int64_t epochs[CLI_BLOCK];
+    double temperature[CLI_BLOCK];
+    double humidity[CLI_BLOCK];
+    double status_temp[CLI_BLOCK];   // What the rules judge, see sensors_status()
+    double status_humid[CLI_BLOCK];
+    AlertLevel temp_levels[CLI_BLOCK];
+    AlertLevel humid_levels[CLI_BLOCK];
+} FileAnalysis;
+
+static FileAnalysis analysis;  // One file at a time, too large for the stack
+
+// Runs the rules over the buffered readings and adds them to the statistics
+static void flush(FileAnalysis *fa) {
+    rules_eval(fa->rules, fa->sensor_ids, fa->epochs, fa->status_temp, fa->status_humid,
+               fa->temp_levels, fa->humid_levels, fa->n);
+    for (size_t i = 0; i < fa->n; i++) {
+        running_stats_add(&fa->stats, fa->epochs[i], fa->temperature[i], fa->humidity[i],
+                          fa->temp_levels[i], fa->humid_levels[i]);
+    }
+    fa->n = 0;
+}
+
+static void add(FileAnalysis *fa, int sensor_id, int64_t epoch, double temperature, double humidity) {
+    if (epoch < fa->from || epoch > fa->to) return;
+    fa->sensor_ids[fa->n] = sensor_id;
+    fa->epochs[fa->n] = epoch;
+    fa->temperature[fa->n] = temperature;
+    fa->humidity[fa->n] = humidity;
+    sensors_status(sensors_get(&fa->sensors, sensor_id), epoch, temperature, humidity,
+                   &fa->status_temp[fa->n], &fa->status_humid[fa->n]);
+    if (++fa->n == CLI_BLOCK) flush(fa);
+}
+
+static bool csv_batch(const Reading *batch, int count, void *user_data) {
+    FileAnalysis *fa = user_data;
+    for (int i = 0; i < count; i++) {
+        add(fa, batch[i].sensor_id, batch[i].epoch, batch[i].temperature, batch[i].humidity);
+    }
+    return true;
+}
+
+static bool analyze_csv(FileAnalysis *fa, const char *filename) {
+    IngestResult result;
+    if (!csv_ingest_file(filename, csv_batch, fa, &result)) return false;
+    fa->skipped += result.rows_skipped;
+    return true;
+}
+
+// Records are read in place from the mapping. In a sorted log a time range starts at
+// the record found through the footer index and ends at the first record after it,
+// any other log is scanned whole and filtered by add().
+static bool analyze_binlog(FileAnalysis *fa, const char *filename) {
+    BinlogReader r;
+    if (!binlog_open(&r, filename)) return false;
+    for (size_t i = binlog_find_epoch(&r, fa->from); i < r.count && !(r.sorted && r.records[i].epoch > fa->to);
+         i++) {
+        const BinlogRecord *rec = &r.records[i];
+        add(fa, rec->sensor_id, rec->epoch, rec->temperature, rec->humidity);
+    }
+    binlog_close(&r);
+    return true;
+}
+
+// One block is decoded at a time. A sorted archive decodes only the blocks from the
+// first one overlapping the time range until one starts after it; in any other a
+// block's first and last epoch do not bound it, so every block is decoded and filtered.
+static bool analyze_archive(FileAnalysis *fa, const char *filename) {
+    ArchiveReader r;
+    ReadingStore staging;
+    bool ok = true;
+    if (!archive_open(&r, filename)) return false;
+
+    store_init(&staging);
+    for (size_t b = archive_find_block(&r, fa->from); b < r.block_count && ok; b++) {
+        if (r.sorted && r.blocks[b].first_epoch > fa->to) break;
+        store_clear(&staging);
+        ok = archive_decode_block(&r, b, &staging) >= 0;
+        for (size_t i = 0; ok && i < staging.count; i++) {
+            add(fa, store_sensor_id(&staging, i), store_epoch(&staging, i),
+                store_temperature(&staging, i), store_humidity(&staging, i));
+        }
+    }
+    store_free(&staging);
+    archive_close(&r);
+    return ok;
+}
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static void begin_analysis(FileAnalysis *fa, RuleEngine *rules) {
+    running_stats_reset(&fa->stats);  // from, to and status_window are set once by main()
+    sensors_clear(&fa->sensors, fa->status_window);
+    rules_reset(rules);
+    fa->rules = rules;
+    fa->skipped = 0;
+    fa->n = 0;
+}
+
+// Statistics and alert counts of one file, the format is taken from the extension:
+// .bin binary log, .thz archive, anything else CSV
+static bool analyze_file(FileAnalysis *fa, RuleEngine *rules, const char *filename) {
+    begin_analysis(fa, rules);
+    bool ok;
+    if (has_suffix(filename, ".bin")) ok = analyze_binlog(fa, filename);
+    else if (has_suffix(filename, ".thz")) ok = analyze_archive(fa, filename);
+    else ok = analyze_csv(fa, filename);
+    if (fa->n > 0) flush(fa);
+    return ok;
+}
+
+// Every input as one time-ordered log. The CSV files are loaded in parallel into one
+// store first, so unlike analyze_file() memory grows with the data.
+static bool analyze_merged(FileAnalysis *fa, RuleEngine *rules, const char *const *filenames, size_t count,
+                           int threads, long long *failed) {
+    ReadingStore store;
+    LoaderResult result;
+    begin_analysis(fa, rules);
+    store_init(&store);
+
+    long long loaded = load_csv_files(filenames, count, threads, &store, &result);
+    for (size_t i = 0; i < store.count; i++) {
+        add(fa, store_sensor_id(&store, i), store_epoch(&store, i), store_temperature(&store, i),
+            store_humidity(&store, i));
+    }
+    if (fa->n > 0) flush(fa);
+    fa->skipped = result.rows_skipped;
+    *failed = result.files_failed;
+    store_free(&store);
+    return loaded >= 0;
+}
+
+// Next input file: the command line files first, then the lines of the list
+static const char *next_input(int argc, char *argv[], int *i, FILE *list, char *path) {
+    if (*i < argc) return argv[(*i)++];
+    while (list && fgets(path, CLI_MAX_PATH, list)) {
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] != '\0') return path;
+    }
+    return NULL;
+}
+
+// Quotes a field when it holds a separator or a quote
+static void write_csv_string(FILE *out, const char *s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        fputs(s, out);
+        return;
+    }
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static void write_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void write_header(FILE *out, OutputFormat format) {
+    if (format == FORMAT_JSON) {
+        fputs("[\n", out);
+    } else {
+        fputs("file,ok,count,skipped,"
+              "avg_temp,stddev_temp,min_temp,min_temp_ts,max_temp,max_temp_ts,"
+              "avg_humid,stddev_humid,min_humid,min_humid_ts,max_humid,max_humid_ts,"
+              "temp_warnings,temp_alerts,humid_warnings,humid_alerts\n", out);
+    }
+}
+
+// One field of a result, a value that is not a finite number is left empty (CSV) or null (JSON)
+static void write_number(FILE *out, OutputFormat format, const char *key, double value, int decimals) {
+    bool finite = isfinite(value);
+    if (format == FORMAT_JSON) {
+        fprintf(out, ", \"%s\": ", key);
+        if (finite) fprintf(out, "%.*f", decimals, value);
+        else fputs("null", out);
+    } else {
+        fputc(',', out);
+        if (finite) fprintf(out, "%.*f", decimals, value);
+    }
+}
+
+static void write_text(FILE *out, OutputFormat format, const char *key, const char *value) {
+    if (format == FORMAT_JSON) {
+        fprintf(out, ", \"%s\": ", key);
+        if (value) write_json_string(out, value);
+        else fputs("null", out);
+    } else {
+        fputc(',', out);
+        if (value) write_csv_string(out, value);
+    }
+}
+
+// One result line (CSV) or object (JSON), written as soon as the file is done
+static void write_result(FILE *out, OutputFormat format, const char *filename, bool ok,
+                         const FileAnalysis *fa, bool first) {
+    Statistics s;
+    const RunningStats *rs = &fa->stats;
+    running_stats_snapshot(rs, &s);
+    bool any = s.count > 0;  // Averages and extremes only exist with readings
+
+    if (format == FORMAT_JSON) {
+        fputs(first ? "  {\"file\": " : ",\n  {\"file\": ", out);
+        write_json_string(out, filename);
+        fprintf(out, ", \"ok\": %s, \"count\": %lld, \"skipped\": %lld", ok ? "true" : "false", s.count, fa->skipped);
+    } else {
+        write_csv_string(out, filename);
+        fprintf(out, ",%d,%lld,%lld", ok ? 1 : 0, s.count, fa->skipped);
+    }
+    write_number(out, format, "avg_temp", any ? s.avg_temp : NAN, 4);
+    write_number(out, format, "stddev_temp", any ? s.stddev_temp : NAN, 4);
+    write_number(out, format, "min_temp", any ? s.min_temp : NAN, 2);
+    write_text(out, format, "min_temp_ts", any ? s.min_temp_ts : NULL);
+    write_number(out, format, "max_temp", any ? s.max_temp : NAN, 2);
+    write_text(out, format, "max_temp_ts", any ? s.max_temp_ts : NULL);
+    write_number(out, format, "avg_humid", any ? s.avg_humid : NAN, 4);
+    write_number(out, format, "stddev_humid", any ? s.stddev_humid : NAN, 4);
+    write_number(out, format, "min_humid", any ? s.min_humid : NAN, 2);
+    write_text(out, format, "min_humid_ts", any ? s.min_humid_ts : NULL);
+    write_number(out, format, "max_humid", any ? s.max_humid : NAN, 2);
+    write_text(out, format, "max_humid_ts", any ? s.max_humid_ts : NULL);
+    write_number(out, format, "temp_warnings", (double)rs->temp_warnings, 0);
+    write_number(out, format, "temp_alerts", (double)rs->temp_alerts, 0);
+    write_number(out, format, "humid_warnings", (double)rs->humid_warnings, 0);
+    write_number(out, format, "humid_alerts", (double)rs->humid_alerts, 0);
+    fputs(format == FORMAT_JSON ? "}" : "\n", out);
+}
+
+static void write_footer(FILE *out, OutputFormat format, bool any) {
+    if (format == FORMAT_JSON) fputs(any ? "\n]\n" : "]\n", out);
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+        "Usage: %s [--format csv|json] [--output FILE] [--rules FILE] [--list FILE] [--merge] [--threads N]\n"
+        "          [--from TIME] [--to TIME] [--status-window N] [FILE...]\n"
+        "Statistics and alert counts of each input file, one result per file.\n"
+        "  FILE           .bin binary log, .thz archive, anything else CSV\n"
+        "  --list FILE    read more input files from FILE, one per line (- for stdin)\n"
+        "  --merge        one result for all inputs (CSV only) as one time-ordered log, loaded in parallel\n"
+        "  --threads N    loader threads for --merge (default one per CPU)\n"
+        "  --from TIME    only readings at or after TIME (YYYY-MM-DD HH:MM[:SS]), .bin and .thz\n"
+        "                 inputs seek to it through their index instead of reading from the start\n"
+        "  --to TIME      only readings at or before TIME\n"
+        "  --rules FILE   alert rules (default %s if present, else the built-in rules)\n"
+        "  --status-window N  readings averaged per sensor before the rules judge them,\n"
+        "                 1 to %d (default %d as in the GUI, 1 = raw readings)\n"
+        "  --output FILE  write the results to FILE instead of stdout\n"
+        "Exit status: 0 all files read, 1 usage error, 2 some files could not be read.\n",
+        program, RULES_FILE, CLI_MAX_STATUS_WINDOW, STATUS_WINDOW_SIZE);
+}
+
+// A --from / --to time, the whole argument must be a timestamp
+static bool parse_time(const char *text, int64_t *epoch) {
+    size_t len;
+    size_t n = strlen(text);
+    return timestamp_parse(text, n, epoch, &len) && len == n;
+}
+
+// Loads the rules, a missing default rules file means the built-in rules
+static bool load_rules(RuleEngine *rules, const char *filename) {
+    int error_line;
+    const char *path = filename ? filename : RULES_FILE;
+    if (!rules_load(rules, path, &error_line)) {
+        if (error_line > 0) {
+            fprintf(stderr, "%s:%d: invalid rule\n", path, error_line);
+            return false;
+        }
+        if (filename) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return false;
+        }
+        rules_defaults(rules);
+    }
+    return rules_compile(rules);
+}
+
+int main(int argc, char *argv[]) {
+    OutputFormat format = FORMAT_CSV;
+    const char *output = NULL, *rules_file = NULL, *list_file = NULL;
+    bool merge = false;
+    int threads = 0;
+    int first_file = argc;
+    analysis.from = INT64_MIN;
+    analysis.to = INT64_MAX;
+    analysis.status_window = STATUS_WINDOW_SIZE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "json") == 0) format = FORMAT_JSON;
+            else if (strcmp(argv[i], "csv") == 0) format = FORMAT_CSV;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rules_file = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            list_file = argv[++i];
+        } else if (strcmp(argv[i], "--merge") == 0) {
+            merge = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--status-window") == 0 && i + 1 < argc) {
+            int size = atoi(argv[++i]);
+            if (size < 1 || size > CLI_MAX_STATUS_WINDOW) {
+                usage(argv[0]);
+                return 1;
+            }
+            analysis.status_window = (size_t)size;
+        } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            if (!parse_time(argv[++i], &analysis.from)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            if (!parse_time(argv[++i], &analysis.to)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            first_file = i;  // Everything from the first file name on is a file
+            break;
+        }
+    }
+    if (first_file == argc && !list_file) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RuleEngine rules;
+    rules_init(&rules);
+    if (!load_rules(&rules, rules_file)) {
+        rules_free(&rules);
+        return 1;
+    }
+
+    FILE *list = NULL;
+    if (list_file) {
+        list = strcmp(list_file, "-") == 0 ? stdin : fopen(list_file, "r");
+        if (!list) {
+            fprintf(stderr, "Cannot read %s\n", list_file);
+            rules_free(&rules);
+            return 1;
+        }
+    }
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", output);
+        if (list && list != stdin) fclose(list);
+        rules_free(&rules);
+        return 1;
+    }
+
+    long long failed = 0;
+    int done = 0, next = first_file;
+    char path[CLI_MAX_PATH];
+    const char *filename;
+    write_header(out, format);
+    if (merge) {
+        // Every name is needed before the load starts
+        char **names = NULL;
+        size_t count = 0, capacity = 0;
+        bool ok = true;
+        while (ok && (filename = next_input(argc, argv, &next, list, path)) != NULL) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                char **grown = realloc(names, capacity * sizeof(char *));
+                if (!grown) {
+                    ok = false;
+                    break;
+                }
+                names = grown;
+            }
+            names[count] = malloc(strlen(filename) + 1);
+            ok = names[count] != NULL;
+            if (ok) strcpy(names[count++], filename);
+        }
+        if (!ok) fprintf(stderr, "Out of memory\n");
+        ok = analyze_merged(&analysis, &rules, (const char *const *)names, count, threads, &failed) && ok;
+        if (failed > 0) fprintf(stderr, "%lld of %zu files could not be read\n", failed, count);
+        if (!ok) failed++;
+        write_result(out, format, "merged", ok, &analysis, true);
+        done = 1;
+        for (size_t i = 0; i < count; i++) free(names[i]);
+        free(names);
+    }
+    while (!merge && (filename = next_input(argc, argv, &next, list, path)) != NULL) {
+        bool ok = analyze_file(&analysis, &rules, filename);
+        if (!ok) {
+            fprintf(stderr, "Cannot read %s\n", filename);
+            failed++;
+        }
+        write_result(out, format, filename, ok, &analysis, done == 0);
+        done++;
+    }
+    write_footer(out, format, done > 0);
+
+    bool written = !ferror(out);
+    if (out != stdout) written = fclose(out) == 0 && written;
+    if (list && list != stdin) fclose(list);
+    rules_free(&rules);
+    sensors_free(&analysis.sensors);
+    if (!written) {
+        fprintf(stderr, "Error writing %s\n", output ? output : "the results");
+        return 2;
+    }
+    return failed > 0 ? 2 : 0;
+}
@@ -0,0 +1,197 @@
+// ingest.c - Streaming CSV Ingest Module
+
+#include "ingest.h"
+#include "instrument.h"
+#include "platform.h"
+#include "timestamp.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NUMBER_LEN 63   // Longest numeric token accepted by the slow path
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Parses a decimal integer, returns the position after it or NULL on failure
+static const char *parse_int(const char *p, const char *end, int *out) {
+    p = skip_blanks(p, end);
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    if (p >= end || !is_digit(*p)) return NULL;
+
+    long long value = 0;
+    while (p < end && is_digit(*p)) {
+        value = value * 10 + (*p - '0');
+        if (value > INT32_MAX) return NULL;  // Out of range for seq_no
+        p++;
+    }
+    *out = (int)(neg ? -value : value);
+    return p;
+}
+
+// Fallback for exponents and long mantissas that the fast path cannot round exactly
+static const char *parse_double_slow(const char *start, const char *end, double *out) {
+    char buf[MAX_NUMBER_LEN + 1];
+    size_t len = 0;
+    const char *p = start;
+    while (p < end && len < MAX_NUMBER_LEN &&
+           (is_digit(*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) {
+        buf[len++] = *p++;
+    }
+    buf[len] = '\0';
+
+    char *stop;
+    *out = strtod(buf, &stop);
+    if (stop == buf) return NULL;
+    return start + (stop - buf);
+}
+
+// Parses a decimal number such as "-12.75", returns the position after it or NULL
+static const char *parse_double(const char *p, const char *end, double *out) {
+    p = skip_blanks(p, end);
+    const char *start = p;
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0, scale = 0;
+    while (p < end && is_digit(*p)) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        digits++;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && is_digit(*p)) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits++;
+            scale++;
+            p++;
+        }
+    }
+    if (digits == 0) return NULL;
+
+    // Up to 15 digits divided by an exact power of ten is correctly rounded
+    if (digits > 15 || (p < end && (*p == 'e' || *p == 'E'))) {
+        return parse_double_slow(start, end, out);
+    }
+
+    double value = (double)mantissa / pow10_table[scale];
+    *out = neg ? -value : value;
+    return p;
+}
+
+// Parses the timestamp field into its epoch and copies its text to out
+static const char *parse_timestamp(const char *p, const char *end, char *out, int64_t *epoch) {
+    size_t len;
+    if (!timestamp_parse(p, (size_t)(end - p), epoch, &len)) return NULL;
+
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return p + len;
+}
+
+// Parses one "seq_no,timestamp,temperature,humidity[,sensor_id]" line (without the newline).
+// Files without the sensor column belong to sensor 0.
+bool csv_parse_line(const char *line, const char *end, Reading *out) {
+    const char *p = line;
+
+    if (!(p = parse_int(p, end, &out->seq_no)) || p >= end || *p++ != ',') return false;
+    if (!(p = parse_timestamp(p, end, out->timestamp, &out->epoch)) || p >= end || *p++ != ',') return false;
+    if (!(p = parse_double(p, end, &out->temperature)) || p >= end || *p++ != ',') return false;
+    if (!(p = parse_double(p, end, &out->humidity))) return false;
+    out->sensor_id = 0;
+    if (p < end && *p == ',' && !(p = parse_int(p + 1, end, &out->sensor_id))) return false;
+
+    // Only trailing blanks (and the '\r' of CRLF files) may follow the last field
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p == end;
+}
+
+// Parses every line in a buffer, result counters are added to (not reset).
+// Returns false when out of memory or when the callback stopped the run (result->stopped).
+bool csv_ingest_buffer(const char *data, size_t size, ReadingBatchFn on_batch,
+                       void *user_data, IngestResult *result) {
+    Reading *batch = malloc(sizeof(Reading) * INGEST_BATCH_SIZE);
+    if (!batch) return false;
+
+    const char *p = data;
+    const char *end = data + size;
+    int count = 0;
+    bool keep_going = true;
+    uint64_t batch_start = INSTRUMENT_NOW();  // Parse time per batch, callbacks excluded
+
+    while (p < end && keep_going) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = nl ? nl : end;
+
+        if (csv_parse_line(p, line_end, &batch[count])) {
+            if (++count == INGEST_BATCH_SIZE) {
+                INSTRUMENT_RECORD(PROBE_PARSE_BATCH, INSTRUMENT_NOW() - batch_start);
+                result->rows_read += count;
+                keep_going = on_batch(batch, count, user_data);
+                count = 0;
+                batch_start = INSTRUMENT_NOW();
+            }
+        } else {
+            // Blank lines are not counted as skipped rows
+            const char *q = p;
+            while (q < line_end && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+            if (q < line_end) result->rows_skipped++;
+        }
+
+        p = nl ? nl + 1 : end;
+    }
+
+    if (count > 0 && keep_going) {
+        INSTRUMENT_RECORD(PROBE_PARSE_BATCH, INSTRUMENT_NOW() - batch_start);
+        result->rows_read += count;
+        keep_going = on_batch(batch, count, user_data);
+    }
+    result->bytes_read += (long long)(p - data);
+    if (!keep_going) result->stopped = true;
+
+    free(batch);
+    return keep_going;
+}
+
+// Streams a whole CSV file through the callback in batches of INGEST_BATCH_SIZE.
+// Returns false if the file cannot be opened, memory runs out or the callback
+// stopped the run; only the last case sets result->stopped.
+bool csv_ingest_file(const char *filename, ReadingBatchFn on_batch, void *user_data,
+                     IngestResult *result) {
+    IngestResult local;
+    if (!result) result = &local;
+    memset(result, 0, sizeof(*result));
+
+    MappedFile mf;
+    if (!map_file(filename, &mf)) return false;  // Return false if file cannot be opened
+
+    double start = monotonic_seconds();
+    bool ok = csv_ingest_buffer(mf.data, mf.size, on_batch, user_data, result);
+    result->seconds = monotonic_seconds() - start;
+    if (result->seconds > 0) {
+        result->mb_per_sec = (double)result->bytes_read / 1e6 / result->seconds;
+    }
+
+    unmap_file(&mf);
+    return ok;
+}
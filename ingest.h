@@ -0,0 +1,32 @@
+// ingest.h - Declaration of ingest.c functions and structures
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "simulator.h"
+
+#define INGEST_BATCH_SIZE 4096   // Readings handed to the callback at once
+
+// Callback receiving each parsed batch, return false to stop the ingest early
+typedef bool (*ReadingBatchFn)(const Reading *batch, int count, void *user_data);
+
+// Declaration of structure to report the outcome of an ingest run
+typedef struct {
+    long long rows_read;      // Rows parsed and handed to the callback
+    long long rows_skipped;   // Non-empty lines that could not be parsed
+    long long bytes_read;     // Bytes of the file that were scanned
+    double seconds;           // Wall time of the whole run
+    double mb_per_sec;        // Throughput in MB (1e6 bytes) per second
+    bool stopped;             // The callback returned false, the rest of the input was not read
+} IngestResult;
+
+// Declaration of required functions
+bool csv_ingest_file(const char *filename, ReadingBatchFn on_batch, void *user_data,
+                     IngestResult *result);
+bool csv_ingest_buffer(const char *data, size_t size, ReadingBatchFn on_batch,
+                       void *user_data, IngestResult *result);
+bool csv_parse_line(const char *line, const char *end, Reading *out);
+
+#endif
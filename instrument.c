@@ -0,0 +1,232 @@
+// instrument.c - Hot Path Instrumentation Module
+
+#include "instrument.h"
+#include "platform.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SUB_COUNT (1u << INSTRUMENT_SUB_BITS)
+
+// Declaration of one thread's counters. Blocks are never freed: a block whose
+// thread ended is handed to the next new thread, its counts stay in the totals.
+typedef struct InstrumentThread {
+    ProbeCounters probes[PROBE_COUNT];
+    atomic_bool in_use;
+    struct InstrumentThread *next;
+} InstrumentThread;
+
+static atomic_bool enabled = true;
+static InstrumentThread *threads = NULL;    // Every block ever allocated
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t thread_key;            // Releases the block when its thread ends
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static _Thread_local InstrumentThread *local = NULL;
+
+static const char *probe_names[PROBE_COUNT] = {
+    "parse batch", "calc_statistics", "GUI per row", "GUI frame", "sample to screen"
+};
+
+static void reset_counters(ProbeCounters *c) {
+    atomic_store_explicit(&c->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&c->min, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&c->max, 0, memory_order_relaxed);
+    for (size_t b = 0; b < INSTRUMENT_BUCKETS; b++) {
+        atomic_store_explicit(&c->buckets[b], 0, memory_order_relaxed);
+    }
+}
+
+static void release_thread(void *block) {
+    atomic_store_explicit(&((InstrumentThread *)block)->in_use, false, memory_order_release);
+}
+
+static void create_key(void) {
+    pthread_key_create(&thread_key, release_thread);
+}
+
+// First record of a thread: reuse a released block or allocate one
+static InstrumentThread *attach_thread(void) {
+    InstrumentThread *t;
+    pthread_once(&key_once, create_key);
+    pthread_mutex_lock(&threads_lock);
+    for (t = threads; t; t = t->next) {
+        if (!atomic_load_explicit(&t->in_use, memory_order_acquire)) break;
+    }
+    if (!t) {
+        t = malloc(sizeof(*t));
+        if (t) {
+            for (int p = 0; p < PROBE_COUNT; p++) reset_counters(&t->probes[p]);
+            t->next = threads;
+            threads = t;
+        }
+    }
+    if (t) atomic_store_explicit(&t->in_use, true, memory_order_relaxed);
+    pthread_mutex_unlock(&threads_lock);
+
+    if (t) pthread_setspecific(thread_key, t);
+    local = t;
+    return t;
+}
+
+// Values below 16 get a bucket each, above that 16 buckets per power of two
+static inline size_t bucket_of(uint64_t v) {
+    if (v < SUB_COUNT) return (size_t)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - INSTRUMENT_SUB_BITS;
+    return ((size_t)(shift + 1) << INSTRUMENT_SUB_BITS) + (size_t)((v >> shift) & (SUB_COUNT - 1));
+}
+
+// Middle of the values that fall into bucket b
+static uint64_t bucket_value(size_t b) {
+    if (b < SUB_COUNT) return b;
+    int shift = (int)(b >> INSTRUMENT_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)(SUB_COUNT + (b & (SUB_COUNT - 1))) << shift;
+    return low + (((uint64_t)1 << shift) >> 1);
+}
+
+uint64_t instrument_now_ns(void) {
+    return (uint64_t)(monotonic_seconds() * 1e9);
+}
+
+// Adds one measurement. Only the calling thread writes its counters, so plain
+// relaxed loads and stores are enough and nothing is locked.
+void instrument_record(ProbeId probe, uint64_t ns) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) return;
+    InstrumentThread *t = local ? local : attach_thread();
+    if (!t) return;
+
+    ProbeCounters *c = &t->probes[probe];
+    atomic_ullong *bucket = &c->buckets[bucket_of(ns)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&c->sum, atomic_load_explicit(&c->sum, memory_order_relaxed) + ns, memory_order_relaxed);
+    if (ns < atomic_load_explicit(&c->min, memory_order_relaxed)) atomic_store_explicit(&c->min, ns, memory_order_relaxed);
+    if (ns > atomic_load_explicit(&c->max, memory_order_relaxed)) atomic_store_explicit(&c->max, ns, memory_order_relaxed);
+}
+
+// Cleanup handler of INSTRUMENT_SCOPE()
+void instrument_scope_end(InstrumentScope *scope) {
+    instrument_record(scope->probe, instrument_now_ns() - scope->start);
+}
+
+void instrument_set_enabled(bool on) {
+    atomic_store(&enabled, on);
+}
+
+bool instrument_enabled(void) {
+    return INSTRUMENT_COMPILED && atomic_load(&enabled);
+}
+
+// Clears every probe. Meant for quiet moments such as the start of a run, a
+// measurement racing with it may survive.
+void instrument_reset(void) {
+    pthread_mutex_lock(&threads_lock);
+    for (InstrumentThread *t = threads; t; t = t->next) {
+        for (int p = 0; p < PROBE_COUNT; p++) reset_counters(&t->probes[p]);
+    }
+    pthread_mutex_unlock(&threads_lock);
+}
+
+// Merges every thread's copy of a probe and reads off the percentiles
+void instrument_snapshot(ProbeId probe, ProbeStats *out) {
+    static unsigned long long merged[INSTRUMENT_BUCKETS];
+    static pthread_mutex_t merge_lock = PTHREAD_MUTEX_INITIALIZER;
+    unsigned long long sum = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->min = UINT64_MAX;
+    pthread_mutex_lock(&merge_lock);
+    memset(merged, 0, sizeof(merged));
+
+    pthread_mutex_lock(&threads_lock);
+    for (InstrumentThread *t = threads; t; t = t->next) {
+        ProbeCounters *c = &t->probes[probe];
+        uint64_t min = atomic_load_explicit(&c->min, memory_order_relaxed);
+        uint64_t max = atomic_load_explicit(&c->max, memory_order_relaxed);
+        sum += atomic_load_explicit(&c->sum, memory_order_relaxed);
+        if (min < out->min) out->min = min;
+        if (max > out->max) out->max = max;
+        for (size_t b = 0; b < INSTRUMENT_BUCKETS; b++) {
+            merged[b] += atomic_load_explicit(&c->buckets[b], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&threads_lock);
+
+    // Counted from the histogram so the percentiles always agree with it
+    for (size_t b = 0; b < INSTRUMENT_BUCKETS; b++) out->count += merged[b];
+    if (out->count == 0) {
+        out->min = 0;
+        pthread_mutex_unlock(&merge_lock);
+        return;
+    }
+    out->mean = (double)sum / (double)out->count;
+
+    const double ranks[4] = { 0.50, 0.90, 0.99, 0.999 };
+    uint64_t *targets[4] = { &out->p50, &out->p90, &out->p99, &out->p999 };
+    unsigned long long seen = 0;
+    int r = 0;
+    for (size_t b = 0; b < INSTRUMENT_BUCKETS && r < 4; b++) {
+        seen += merged[b];
+        while (r < 4 && seen > 0 && (double)seen >= ranks[r] * (double)out->count) {
+            uint64_t v = bucket_value(b);
+            *targets[r++] = v > out->max ? out->max : v;  // The last bucket is wider than the data
+        }
+    }
+    pthread_mutex_unlock(&merge_lock);
+}
+
+const char *instrument_probe_name(ProbeId probe) {
+    return probe < PROBE_COUNT ? probe_names[probe] : "?";
+}
+
+// Nanoseconds with a unit that keeps 3 significant digits
+static void format_ns(double ns, char *out, size_t size) {
+    if (ns < 1e3) snprintf(out, size, "%.0f ns", ns);
+    else if (ns < 1e6) snprintf(out, size, "%.1f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(out, size, "%.1f ms", ns / 1e6);
+    else snprintf(out, size, "%.2f s", ns / 1e9);
+}
+
+// One line per probe: count, mean, percentiles and maximum. Returns the length written.
+size_t instrument_report(char *out, size_t size) {
+    size_t len = 0;
+    if (size == 0) return 0;
+    out[0] = '\0';
+
+    if (!INSTRUMENT_COMPILED) {
+        snprintf(out, size, "Instrumentation compiled out (INSTRUMENT_OFF).");
+        return strlen(out);
+    }
+    for (int p = 0; p < PROBE_COUNT && len < size; p++) {
+        ProbeStats s;
+        char mean[16], p50[16], p99[16], p999[16], max[16];
+        instrument_snapshot((ProbeId)p, &s);
+        format_ns(s.mean, mean, sizeof(mean));
+        format_ns((double)s.p50, p50, sizeof(p50));
+        format_ns((double)s.p99, p99, sizeof(p99));
+        format_ns((double)s.p999, p999, sizeof(p999));
+        format_ns((double)s.max, max, sizeof(max));
+        int n = snprintf(out + len, size - len, "%s%-16s %10llu  mean %-9s p50 %-9s p99 %-9s p99.9 %-9s max %s",
+                         p > 0 ? "\n" : "", probe_names[p], s.count, mean, p50, p99, p999, max);
+        if (n < 0) break;
+        len += (size_t)n < size - len ? (size_t)n : size - len - 1;
+    }
+    return len;
+}
+
+// Appends a time-stamped report to a file, for periodic dumps
+bool instrument_dump(const char *filename) {
+    char report[INSTRUMENT_REPORT_SIZE];
+    char when[32];
+    time_t now = time(NULL);
+    struct tm tm_info;
+
+    FILE *f = fopen(filename, "a");
+    if (!f) return false;
+    if (!platform_localtime(now, &tm_info)) memset(&tm_info, 0, sizeof(tm_info));
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm_info);
+    instrument_report(report, sizeof(report));
+    fprintf(f, "[%s]\n%s\n\n", when, report);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,77 @@
+// instrument.h - Declaration of instrument.c functions and structures
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Build with -DINSTRUMENT_OFF to compile every probe out of the hot paths
+
+#define INSTRUMENT_SUB_BITS 4    // 16 sub-buckets per power of two, values kept within 1/16
+#define INSTRUMENT_BUCKETS ((64 - INSTRUMENT_SUB_BITS + 1) << INSTRUMENT_SUB_BITS)
+#define INSTRUMENT_REPORT_SIZE 1024  // Buffer size that holds instrument_report() for every probe
+
+// Hot paths that are measured, values are nanoseconds
+typedef enum {
+    PROBE_PARSE_BATCH,           // Parsing one ingest batch of CSV lines
+    PROBE_CALC_STATISTICS,       // One statistics call
+    PROBE_GUI_ROW,               // GUI work per reading shown (store, status, model, update_gui)
+    PROBE_GUI_FRAME,             // One frame of the reading drain
+    PROBE_SAMPLE_TO_SCREEN,      // Reading published by the worker until the frame that shows it
+    PROBE_COUNT
+} ProbeId;
+
+// Declaration of one probe's counters and log-linear (HDR style) latency histogram.
+// Each thread owns its copy and is its only writer, so no atomic read-modify-write
+// is needed; readers merge all copies.
+typedef struct {
+    atomic_ullong sum;
+    atomic_ullong min;
+    atomic_ullong max;
+    atomic_ullong buckets[INSTRUMENT_BUCKETS];
+} ProbeCounters;
+
+// Declaration of merged probe figures, in nanoseconds
+typedef struct {
+    unsigned long long count;
+    double mean;
+    uint64_t min, max;
+    uint64_t p50, p90, p99, p999;
+} ProbeStats;
+
+// Declaration of scoped timer, records when the enclosing block is left
+typedef struct {
+    ProbeId probe;
+    uint64_t start;
+} InstrumentScope;
+
+// Declaration of required functions
+uint64_t instrument_now_ns(void);
+void instrument_record(ProbeId probe, uint64_t ns);
+void instrument_scope_end(InstrumentScope *scope);
+void instrument_set_enabled(bool enabled);
+bool instrument_enabled(void);
+void instrument_reset(void);
+void instrument_snapshot(ProbeId probe, ProbeStats *out);
+const char *instrument_probe_name(ProbeId probe);
+size_t instrument_report(char *out, size_t size);
+bool instrument_dump(const char *filename);
+
+#ifndef INSTRUMENT_OFF
+#define INSTRUMENT_COMPILED 1
+#define INSTRUMENT_NOW() instrument_now_ns()
+#define INSTRUMENT_RECORD(probe, ns) instrument_record((probe), (ns))
+// Times the rest of the enclosing block, one per block
+#define INSTRUMENT_SCOPE(probe) \
+    InstrumentScope instrument_scope __attribute__((cleanup(instrument_scope_end))) = { (probe), instrument_now_ns() }
+#else
+#define INSTRUMENT_COMPILED 0
+#define INSTRUMENT_NOW() ((uint64_t)0)
+#define INSTRUMENT_RECORD(probe, ns) ((void)(ns))
+#define INSTRUMENT_SCOPE(probe) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,517 @@
+// loader.c - Parallel Multi-File Loader Module
+
+#include "loader.h"
+#include "ingest.h"
+#include "store.h"
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MERGE_BLOCK 4096     // Readings collected before each store_append_block()
+
+// Declaration of shared state of one load
+typedef struct {
+    LoaderFile *files;
+    size_t file_count;
+    LoaderDeque *deques;     // One per worker
+    int threads;
+    atomic_size_t pending;   // Tasks queued or running, the workers stop at 0
+    atomic_llong steals;
+} LoaderJob;
+
+typedef struct {
+    LoaderJob *job;
+    int id;
+    uint32_t rng;            // Picks the first victim when stealing
+} LoaderWorker;
+
+static bool deque_init(LoaderDeque *d) {
+    memset(d, 0, sizeof(*d));
+    return pthread_mutex_init(&d->lock, NULL) == 0;
+}
+
+static void deque_free(LoaderDeque *d) {
+    pthread_mutex_destroy(&d->lock);
+    free(d->tasks);
+}
+
+static bool deque_push(LoaderDeque *d, LoaderTask task) {
+    bool ok = true;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail == d->capacity) {
+        if (d->head > 0) {
+            // Reuse the room left by stolen tasks before growing
+            memmove(d->tasks, d->tasks + d->head, (d->tail - d->head) * sizeof(LoaderTask));
+            d->tail -= d->head;
+            d->head = 0;
+        } else {
+            size_t capacity = d->capacity ? d->capacity * 2 : 64;
+            LoaderTask *tasks = realloc(d->tasks, capacity * sizeof(LoaderTask));
+            if (tasks) {
+                d->tasks = tasks;
+                d->capacity = capacity;
+            } else {
+                ok = false;
+            }
+        }
+    }
+    if (ok) d->tasks[d->tail++] = task;
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// Owner side, newest task first
+static bool deque_pop(LoaderDeque *d, LoaderTask *task) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *task = d->tasks[--d->tail];
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// Thief side, oldest task first
+static bool deque_steal(LoaderDeque *d, LoaderTask *task) {
+    bool found = false;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *task = d->tasks[d->head++];
+        found = true;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static bool segment_reserve(LoaderSegment *s, size_t n) {
+    if (s->count + n <= s->capacity) return true;
+    size_t capacity = s->capacity ? s->capacity : 4096;
+    while (capacity < s->count + n) capacity *= 2;
+
+    int64_t *epoch = realloc(s->epoch, capacity * sizeof(int64_t));
+    if (epoch) s->epoch = epoch;
+    double *temperature = realloc(s->temperature, capacity * sizeof(double));
+    if (temperature) s->temperature = temperature;
+    double *humidity = realloc(s->humidity, capacity * sizeof(double));
+    if (humidity) s->humidity = humidity;
+    int *seq_no = realloc(s->seq_no, capacity * sizeof(int));
+    if (seq_no) s->seq_no = seq_no;
+    int32_t *sensor_id = realloc(s->sensor_id, capacity * sizeof(int32_t));
+    if (sensor_id) s->sensor_id = sensor_id;
+    if (!epoch || !temperature || !humidity || !seq_no || !sensor_id) return false;
+
+    s->capacity = capacity;
+    return true;
+}
+
+static void segment_free(LoaderSegment *s) {
+    free(s->epoch);
+    free(s->temperature);
+    free(s->humidity);
+    free(s->seq_no);
+    free(s->sensor_id);
+    memset(s, 0, sizeof(*s));
+}
+
+static bool segment_batch(const Reading *batch, int count, void *user_data) {
+    LoaderSegment *s = user_data;
+    if (!segment_reserve(s, (size_t)count)) {
+        s->failed = true;
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        int64_t epoch = batch[i].epoch;
+        if (s->count > 0 && epoch < s->epoch[s->count - 1]) s->sorted = false;
+        s->epoch[s->count] = epoch;
+        s->temperature[s->count] = batch[i].temperature;
+        s->humidity[s->count] = batch[i].humidity;
+        s->seq_no[s->count] = batch[i].seq_no;
+        s->sensor_id[s->count] = batch[i].sensor_id;
+        s->count++;
+    }
+    return true;
+}
+
+typedef struct {
+    int64_t epoch;
+    size_t row;
+} SortKey;
+
+// Equal epochs keep their file order
+static int compare_keys(const void *a, const void *b) {
+    const SortKey *x = a, *y = b;
+    if (x->epoch != y->epoch) return x->epoch < y->epoch ? -1 : 1;
+    return (x->row > y->row) - (x->row < y->row);
+}
+
+// Puts the rows of an out-of-order piece in time order, so the merge only sees sorted runs
+static bool segment_sort(LoaderSegment *s) {
+    SortKey *keys = malloc(s->count * sizeof(SortKey));
+    LoaderSegment sorted;
+    memset(&sorted, 0, sizeof(sorted));
+    if (!keys || !segment_reserve(&sorted, s->count)) {
+        free(keys);
+        segment_free(&sorted);
+        return false;
+    }
+
+    for (size_t i = 0; i < s->count; i++) {
+        keys[i].epoch = s->epoch[i];
+        keys[i].row = i;
+    }
+    qsort(keys, s->count, sizeof(SortKey), compare_keys);
+    for (size_t i = 0; i < s->count; i++) {
+        size_t row = keys[i].row;
+        sorted.epoch[i] = s->epoch[row];
+        sorted.temperature[i] = s->temperature[row];
+        sorted.humidity[i] = s->humidity[row];
+        sorted.seq_no[i] = s->seq_no[row];
+        sorted.sensor_id[i] = s->sensor_id[row];
+    }
+    free(keys);
+
+    sorted.count = s->count;
+    sorted.sorted = true;
+    sorted.rows_skipped = s->rows_skipped;
+    segment_free(s);
+    *s = sorted;
+    return true;
+}
+
+// Parses one piece of a mapped file into its segment
+static void run_chunk(LoaderFile *file, uint32_t chunk) {
+    LoaderSegment *s = &file->segments[chunk];
+    IngestResult result;
+    size_t from = file->bounds[chunk], to = file->bounds[chunk + 1];
+
+    s->sorted = true;
+    memset(&result, 0, sizeof(result));  // csv_ingest_buffer() adds to it
+    if (to > from && !csv_ingest_buffer(file->mf.data + from, to - from, segment_batch, s, &result)) {
+        s->failed = true;  // Out of memory, in the parser or in segment_batch()
+    }
+    s->rows_skipped += result.rows_skipped;
+    if (!s->failed && !s->sorted && !segment_sort(s)) s->failed = true;
+
+    if (atomic_fetch_sub(&file->remaining, 1) == 1) unmap_file(&file->mf);  // Last piece of the file
+}
+
+// Maps a file and cuts it into newline-aligned pieces of about LOADER_CHUNK_BYTES.
+// The other pieces go to this worker's deque where idle workers can steal them,
+// the first one is parsed right away.
+static void run_file(LoaderJob *job, LoaderWorker *w, uint32_t f) {
+    LoaderFile *file = &job->files[f];
+    if (!map_file(file->name, &file->mf)) return;
+    file->mapped = true;
+
+    size_t size = file->mf.size;
+    size_t chunks = size / LOADER_CHUNK_BYTES + 1;
+    if (chunks > UINT32_MAX - 1) chunks = UINT32_MAX - 1;
+    file->bounds = malloc((chunks + 1) * sizeof(size_t));
+    file->segments = calloc(chunks, sizeof(LoaderSegment));
+    if (!file->bounds || !file->segments) {
+        file->failed = true;
+        unmap_file(&file->mf);
+        return;
+    }
+
+    file->bounds[0] = 0;
+    for (size_t k = 1; k < chunks; k++) {
+        size_t at = size / chunks * k;
+        if (at < file->bounds[k - 1]) at = file->bounds[k - 1];
+        const char *nl = at < size ? memchr(file->mf.data + at, '\n', size - at) : NULL;
+        file->bounds[k] = nl ? (size_t)(nl - file->mf.data) + 1 : size;
+    }
+    file->bounds[chunks] = size;
+    file->chunk_count = (uint32_t)chunks;
+    atomic_store(&file->remaining, (unsigned)chunks);
+
+    atomic_fetch_add(&job->pending, chunks - 1);  // Before any piece can be finished
+    for (size_t k = chunks - 1; k >= 1; k--) {
+        LoaderTask task = { f, (uint32_t)k };
+        if (!deque_push(&job->deques[w->id], task)) {
+            run_chunk(file, (uint32_t)k);  // No room to queue it, parse it here
+            atomic_fetch_sub(&job->pending, 1);
+        }
+    }
+    run_chunk(file, 0);
+}
+
+static bool steal(LoaderJob *job, LoaderWorker *w, LoaderTask *task) {
+    w->rng ^= w->rng << 13;  // xorshift32
+    w->rng ^= w->rng >> 17;
+    w->rng ^= w->rng << 5;
+    int start = (int)(w->rng % (uint32_t)job->threads);
+    for (int i = 0; i < job->threads; i++) {
+        int victim = (start + i) % job->threads;
+        if (victim != w->id && deque_steal(&job->deques[victim], task)) {
+            atomic_fetch_add_explicit(&job->steals, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *loader_worker(void *arg) {
+    LoaderWorker *w = arg;
+    LoaderJob *job = w->job;
+    LoaderTask task;
+
+    while (atomic_load(&job->pending) > 0) {
+        if (!deque_pop(&job->deques[w->id], &task) && !steal(job, w, &task)) {
+            sched_yield();  // Everything left is running, a file being split may still add pieces
+            continue;
+        }
+        if (task.chunk == LOADER_FILE_TASK) run_file(job, w, task.file);
+        else run_chunk(&job->files[task.file], task.chunk);
+        atomic_fetch_sub(&job->pending, 1);
+    }
+    return NULL;
+}
+
+// Declaration of a sorted piece being merged
+typedef struct {
+    const LoaderSegment *segment;
+    size_t pos;
+    size_t order;            // File and piece order, breaks ties between equal epochs
+} MergeCursor;
+
+static inline bool cursor_before(const MergeCursor *a, const MergeCursor *b) {
+    int64_t x = a->segment->epoch[a->pos], y = b->segment->epoch[b->pos];
+    return x < y || (x == y && a->order < b->order);
+}
+
+static void sift_down(MergeCursor *heap, size_t n, size_t i) {
+    for (;;) {
+        size_t smallest = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && cursor_before(&heap[l], &heap[smallest])) smallest = l;
+        if (r < n && cursor_before(&heap[r], &heap[smallest])) smallest = r;
+        if (smallest == i) return;
+        MergeCursor t = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = t;
+        i = smallest;
+    }
+}
+
+static int compare_cursors(const void *a, const void *b) {
+    const MergeCursor *x = a, *y = b;
+    if (cursor_before(x, y)) return -1;
+    return cursor_before(y, x) ? 1 : 0;
+}
+
+// Appends the sorted pieces to the store in time order. Daily files of one logger
+// do not overlap, then the pieces are simply appended one after another; otherwise
+// a k-way merge over a heap of pieces is used.
+static bool merge_segments(MergeCursor *cursors, size_t n, ReadingStore *store, bool *in_order) {
+    qsort(cursors, n, sizeof(MergeCursor), compare_cursors);
+    *in_order = true;
+    for (size_t i = 1; i < n && *in_order; i++) {
+        const LoaderSegment *prev = cursors[i - 1].segment;
+        *in_order = prev->epoch[prev->count - 1] <= cursors[i].segment->epoch[0];
+    }
+
+    if (*in_order) {
+        for (size_t i = 0; i < n; i++) {
+            const LoaderSegment *s = cursors[i].segment;
+            if (store_append_block(store, s->epoch, s->temperature, s->humidity, s->seq_no, s->sensor_id,
+                                   s->count) != s->count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The sorted cursor array is already a valid heap
+    LoaderSegment block;
+    memset(&block, 0, sizeof(block));
+    if (!segment_reserve(&block, MERGE_BLOCK)) return false;
+    size_t heap_size = n;
+    bool ok = true;
+    while (heap_size > 0 && ok) {
+        MergeCursor *top = &cursors[0];
+        const LoaderSegment *s = top->segment;
+        size_t k = block.count++;
+        block.epoch[k] = s->epoch[top->pos];
+        block.temperature[k] = s->temperature[top->pos];
+        block.humidity[k] = s->humidity[top->pos];
+        block.seq_no[k] = s->seq_no[top->pos];
+        block.sensor_id[k] = s->sensor_id[top->pos];
+        if (block.count == MERGE_BLOCK || heap_size == 1) {
+            // The last piece left is copied in one go
+            ok = store_append_block(store, block.epoch, block.temperature, block.humidity, block.seq_no,
+                                    block.sensor_id, block.count) == block.count;
+            block.count = 0;
+            if (heap_size == 1 && ok) {
+                size_t rest = s->count - top->pos - 1;
+                ok = store_append_block(store, s->epoch + top->pos + 1, s->temperature + top->pos + 1,
+                                        s->humidity + top->pos + 1, s->seq_no + top->pos + 1,
+                                        s->sensor_id + top->pos + 1, rest) == rest;
+                break;
+            }
+        }
+        if (++top->pos == s->count) cursors[0] = cursors[--heap_size];
+        sift_down(cursors, heap_size, 0);
+    }
+    segment_free(&block);
+    return ok;
+}
+
+// Loads CSV files in parallel and appends their readings to the store in time order.
+// Every file is a task; files larger than LOADER_CHUNK_BYTES are split at newlines
+// into pieces that are tasks of their own. Tasks run on threads workers (0 = one per
+// CPU) that steal from each other when their own deque runs dry.
+// Returns the readings appended, or -1 if no file could be read or memory ran out.
+long long load_csv_files(const char *const *filenames, size_t count, int threads, ReadingStore *store,
+                         LoaderResult *result) {
+    LoaderResult local;
+    if (!result) result = &local;
+    memset(result, 0, sizeof(*result));
+    if (count == 0) return 0;
+    if (count > UINT32_MAX - 1) return -1;
+
+    double start = monotonic_seconds();
+    if (threads <= 0) threads = cpu_count();
+    if (threads > LOADER_MAX_THREADS) threads = LOADER_MAX_THREADS;
+    result->threads = threads;
+
+    LoaderJob job;
+    memset(&job, 0, sizeof(job));
+    job.files = calloc(count, sizeof(LoaderFile));
+    job.deques = calloc((size_t)threads, sizeof(LoaderDeque));
+    LoaderWorker *workers = calloc((size_t)threads, sizeof(LoaderWorker));
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)threads);
+    int deques = 0;
+    bool ok = job.files && job.deques && workers && tids;
+    for (; ok && deques < threads; deques++) ok = deque_init(&job.deques[deques]);
+
+    // Files are dealt to the workers round robin, stealing evens out the rest
+    job.file_count = count;
+    job.threads = threads;
+    atomic_init(&job.pending, count);
+    atomic_init(&job.steals, 0);
+    for (size_t f = 0; ok && f < count; f++) {
+        job.files[f].name = filenames[f];
+        LoaderTask task = { (uint32_t)f, LOADER_FILE_TASK };
+        ok = deque_push(&job.deques[f % (size_t)threads], task);
+    }
+
+    if (ok) {
+        int started = 0;
+        for (int i = 0; i < threads; i++) {
+            workers[i].job = &job;
+            workers[i].id = i;
+            workers[i].rng = 2654435761u * (uint32_t)(i + 1);
+        }
+        // The calling thread is worker 0
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&tids[i], NULL, loader_worker, &workers[i]) != 0) break;
+            started++;
+        }
+        loader_worker(&workers[0]);
+        for (int i = 1; i <= started; i++) pthread_join(tids[i], NULL);
+    }
+
+    // Collect the pieces in file order
+    size_t pieces = 0;
+    for (size_t f = 0; ok && f < count; f++) pieces += job.files[f].chunk_count;
+    MergeCursor *cursors = ok ? malloc((pieces ? pieces : 1) * sizeof(MergeCursor)) : NULL;
+    size_t n = 0, order = 0;
+    ok = ok && cursors;
+    for (size_t f = 0; f < count && job.files; f++) {
+        LoaderFile *file = &job.files[f];
+        if (!file->mapped) result->files_failed++;
+        else result->files_loaded++;
+        if (file->failed) ok = false;
+        result->tasks += 1 + (file->chunk_count > 1 ? file->chunk_count - 1 : 0);
+        for (uint32_t k = 0; k < file->chunk_count; k++) {
+            LoaderSegment *s = &file->segments[k];
+            result->rows_read += (long long)s->count;
+            result->rows_skipped += s->rows_skipped;
+            if (s->failed) ok = false;
+            if (ok && s->count > 0) {
+                cursors[n].segment = s;
+                cursors[n].pos = 0;
+                cursors[n].order = order;
+                n++;
+            }
+            order++;
+        }
+        if (file->chunk_count > 0) result->bytes_read += (long long)file->bounds[file->chunk_count];
+    }
+
+    size_t before = store->count;
+    if (ok && !merge_segments(cursors, n, store, &result->merged_in_order)) ok = false;
+    result->steals = atomic_load(&job.steals);
+
+    for (size_t f = 0; f < count && job.files; f++) {
+        LoaderFile *file = &job.files[f];
+        for (uint32_t k = 0; k < file->chunk_count; k++) segment_free(&file->segments[k]);
+        free(file->segments);
+        free(file->bounds);
+    }
+    for (int i = 0; i < deques; i++) deque_free(&job.deques[i]);
+    free(cursors);
+    free(job.files);
+    free(job.deques);
+    free(workers);
+    free(tids);
+
+    result->seconds = monotonic_seconds() - start;
+    if (result->seconds > 0) result->mb_per_sec = (double)result->bytes_read / 1e6 / result->seconds;
+    if (!ok || result->files_loaded == 0) return -1;
+    return (long long)(store->count - before);
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Loads every *.csv file of a directory, see load_csv_files()
+long long load_csv_directory(const char *directory, int threads, ReadingStore *store, LoaderResult *result) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        if (result) memset(result, 0, sizeof(*result));
+        return -1;
+    }
+
+    char **names = NULL;
+    size_t count = 0, capacity = 0;
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < 5 || strcmp(entry->d_name + len - 4, ".csv") != 0) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char **grown = realloc(names, capacity * sizeof(char *));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            names = grown;
+        }
+        size_t size = strlen(directory) + len + 2;
+        names[count] = malloc(size);
+        if (!names[count]) {
+            ok = false;
+            break;
+        }
+        snprintf(names[count], size, "%s/%s", directory, entry->d_name);
+        count++;
+    }
+    closedir(dir);
+
+    long long loaded = -1;
+    if (ok) {
+        qsort(names, count, sizeof(char *), compare_names);  // Daily files are named by date
+        loaded = load_csv_files((const char *const *)names, count, threads, store, result);
+    } else if (result) {
+        memset(result, 0, sizeof(*result));
+    }
+    for (size_t i = 0; i < count; i++) free(names[i]);
+    free(names);
+    return loaded;
+}
@@ -0,0 +1,80 @@
+// loader.h - Declaration of loader.c functions and structures
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "platform.h"
+#include "simulator.h"
+
+#define LOADER_CHUNK_BYTES (4u << 20)  // Files larger than this are parsed in pieces of about this size
+#define LOADER_MAX_THREADS 256
+#define LOADER_FILE_TASK UINT32_MAX    // LoaderTask.chunk of a task that maps and splits a file
+
+// Declaration of one task: a whole file, or one newline-aligned piece of it
+typedef struct {
+    uint32_t file;
+    uint32_t chunk;                    // LOADER_FILE_TASK, or the piece to parse
+} LoaderTask;
+
+// Declaration of a worker's task deque. The owner pushes and pops at the tail
+// (newest first, its pieces are still in cache), thieves take from the head
+// (oldest, usually the largest remaining work).
+typedef struct {
+    pthread_mutex_t lock;
+    LoaderTask *tasks;
+    size_t head, tail;                 // Queued tasks are [head, tail)
+    size_t capacity;
+} LoaderDeque;
+
+// Declaration of readings parsed from one piece, as columns
+typedef struct {
+    int64_t *epoch;
+    double *temperature;
+    double *humidity;
+    int *seq_no;
+    int32_t *sensor_id;
+    size_t count;
+    size_t capacity;
+    bool sorted;                       // Epochs never decrease (after loading, always true)
+    bool failed;                       // Out of memory while parsing
+    long long rows_skipped;
+} LoaderSegment;
+
+// Declaration of one input file and the pieces it was split into
+typedef struct {
+    const char *name;
+    MappedFile mf;
+    bool mapped;                       // Opened, false for a file that could not be read
+    bool failed;                       // Out of memory while splitting
+    uint32_t chunk_count;
+    size_t *bounds;                    // chunk_count + 1 byte offsets, each piece ends after a newline
+    LoaderSegment *segments;           // One per piece
+    atomic_uint remaining;             // Pieces not parsed yet, the last one unmaps the file
+} LoaderFile;
+
+// Declaration of the outcome of a load
+typedef struct {
+    long long files_loaded;
+    long long files_failed;            // Could not be opened
+    long long rows_read;
+    long long rows_skipped;
+    long long bytes_read;
+    long long tasks;                   // Files plus pieces
+    long long steals;                  // Tasks taken from another worker's deque
+    int threads;
+    bool merged_in_order;              // Pieces did not overlap in time, no merge was needed
+    double seconds;
+    double mb_per_sec;
+} LoaderResult;
+
+// Declaration of required functions
+long long load_csv_files(const char *const *filenames, size_t count, int threads, ReadingStore *store,
+                         LoaderResult *result);
+long long load_csv_directory(const char *directory, int threads, ReadingStore *store, LoaderResult *result);
+
+#endif
@@ -4,235 +4,628 @@
 #include <string.h>
 #include "simulator.h"
 #include "stats.h"
-
-//x86_64-w64-mingw32-gcc main.c simulator.c stats.c -o app $(pkg-config --cflags --libs gtk+-3.0)
+#include "store.h"
+#include "window.h"
+#include "binlog.h"
+#include "archive.h"
+#include "tindex.h"
+#include "rollup.h"
+#include "reading_model.h"
+#include "timestamp.h"
+#include "platform.h"
+#include "acquire.h"
+#include "sensors.h"
+#include "instrument.h"
+#include "chart.h"
+#include "rules.h"
+
+//x86_64-w64-mingw32-gcc main.c simulator.c stats.c ingest.c platform.c store.c timestamp.c window.c binlog.c archive.c tindex.c rollup.c reading_model.c ringbuf.c acquire.c tail.c sensors.c workload.c instrument.c chart.c rules.c arena.c -o app -pthread $(pkg-config --cflags --libs gtk+-3.0)
 
 // Constants
-#define MAX_LOG_SIZE 50        // Maximum # readings
-#define ALERT_THRESHOLD 65      // Exceeded threshold
-#define WARNING_THRESHOLD 60    // Warning threshold
-
-// Global data structure
-Reading readings[MAX_LOG_SIZE];
+#define MAX_LOG_SIZE 100000000 // Upper limit offered by the readings spinner
+#define DEFAULT_LOG_SIZE 50     // # readings selected by default
+#define MAX_STATUS_WINDOW 100   // Upper limit offered by the status window spinner
+#define MAX_SIMULATED_SENSORS 1000  // Upper limit offered by the simulated sensors spinner
+#define MAX_RANDOM_SEED 2147483647  // Upper limit offered by the seed spinner
+#define TREND_WINDOW_SECONDS (6 * 3600)  // Span of the rolling trend in the live panel
+#define OVERVIEW_ROWS 48        // Most rollup rows listed by the overview
+#define UPDATE_INTERVAL_MS 500  // Default time between readings
+#define MAX_UPDATE_INTERVAL 10000  // Upper limit offered by the interval spinner
+#define FRAME_BUDGET_SECONDS 0.008  // Time per frame spent draining readings (half a 60 fps frame)
+#define INSTRUMENT_PANEL_MS 1000    // Refresh period of the instrumentation panel
+#define INSTRUMENT_DUMP_SECONDS 10  // Period of the instrumentation dump to INSTRUMENT_LOG
+#define INSTRUMENT_LOG "instrument.log"
+
+// Global data structure (grows on demand, no compile-time limit)
+ReadingStore readings;
 Statistics stats;
-
-static GtkListStore *list_store;
+static RunningStats live_stats;     // Updated per reading, never rescans the store
+static SensorSet sensor_set;        // Per-sensor rows, live aggregates and status windows
+static RollingWindow trend_window;  // Last TREND_WINDOW_SECONDS of samples
+static TimeIndex readings_index;    // Zone map over the loaded readings, answers range queries
+static Rollup readings_rollup;      // Minute/hour/day aggregates for overviews
+static gboolean rollup_from_file;   // readings_rollup was loaded from "<data file>.rollup" (whole file)
+static Chart readings_chart;        // Both channels over time, decimated per pixel column
+static RuleEngine rule_engine;      // Alert rules from RULES_FILE, reloaded for every run
+
+static ReadingModel *reading_model; // Table rows, formatted from the store only when drawn
 static GtkWidget *tree_view;
 static GtkWidget *readings_spinner;
-static GtkTreeIter current_iter;
-static gboolean has_current_iter = FALSE;
+static GtkWidget *live_label;
+static GtkWidget *instrument_label;
+static GtkWidget *status_window_spinner;
+static GtkWidget *interval_spinner;
+static GtkWidget *stop_button;
+static GtkWidget *sensors_spinner;
+static GtkWidget *seed_spinner;
+static GtkWidget *sensor_combo;
+static GtkWidget *query_from_entry;
+static GtkWidget *query_to_entry;
+static Acquisition acquisition;     // Worker thread reading the selected source into a ring
+static gboolean acquisition_active = FALSE; // A run is going and its readings are not all shown
+static const char *run_filename = NULL; // Data file of the current run, NULL for random readings
+static guint drain_tick = 0;        // Frame clock tick callback, 0 when not running
+static long long current_row = -1;  // Row of the latest reading, -1 when none is highlighted
+static int selected_sensor = -1;    // Shard shown in the live panel and range queries, -1 = all sensors
+static size_t sensors_listed = 0;   // Shards already offered by the sensor selector
 
 // Global variables to manage application state and user preferences
-static int selected_log_size = 50;                  // Default # of readings
-static int input_mode = 1;                          // Input modes 1=random, 2=default CSV, 3=test CSV
+static int selected_log_size = DEFAULT_LOG_SIZE;    // Default # of readings
+static int status_window_size = STATUS_WINDOW_SIZE; // # samples in the status moving average
+static int update_interval_ms = UPDATE_INTERVAL_MS; // Time between readings, 0 = as fast as possible
+static int sensor_count = 1;                        // Sensors simulated by the random generator
+static int random_seed = 0;                         // Seed of the random generator, 0 = new seed each run
+static int input_mode = 1;                          // Input modes 1=random, 2=default CSV, 3=test CSV, 4=binary log, 5=archive, 6=live tail
 static char csv_filename[256] = "readings.csv";     // Simulation data csv file
+static const char *bin_filename = "readings.bin";   // Binary log, converted from source_csv_filename if missing
+static const char *archive_filename = "readings.thz"; // Compressed archive, converted from source_csv_filename if missing
+static const char *source_csv_filename = "readings.csv"; // CSV the binary log and archive are created from
 
-// Humidity Status col
+// Colors of the status columns indexed by AlertLevel, parsed once in build_gui()
+static const char *level_color_names[] = { "green", "orange", "red" };
+static GdkRGBA level_colors[3];
+static GdkRGBA current_row_color;
+
+// Temperature Status col
 void temp_status_cell_data_func(GtkTreeViewColumn *col, GtkCellRenderer *renderer,
                                GtkTreeModel *model, GtkTreeIter *iter, gpointer data) {
-    gchar *status;
-    gtk_tree_model_get(model, iter, 4, &status, -1);
-    
-    const char *color;
-    if (strstr(status, "Alert!") != NULL) {
-        color = "red";
-    } else if (strstr(status, "Warning!") != NULL) {
-        color = "orange";
-    } else {
-        color = "green";
-    }
-    
-    // Make the current row selected
-    gboolean is_current = FALSE;
-    if (has_current_iter) {
-        GtkTreePath *current_path = gtk_tree_model_get_path(model, &current_iter);
-        GtkTreePath *iter_path = gtk_tree_model_get_path(model, iter);
-        if (gtk_tree_path_compare(current_path, iter_path) == 0) {
-            is_current = TRUE;
-        }
-        gtk_tree_path_free(current_path);
-        gtk_tree_path_free(iter_path);
-    }
-    
+    size_t row = reading_model_iter_row(iter);
     g_object_set(renderer,
-        "foreground", color,
+        "foreground-rgba", &level_colors[reading_model_temp_level(reading_model, row)],
         "weight", PANGO_WEIGHT_BOLD,
-        "background", is_current ? "white" : NULL,
+        "background-rgba", (long long)row == current_row ? &current_row_color : NULL,
         NULL);
-    g_free(status);
 }
 
 // Humidity Status col
 void humid_status_cell_data_func(GtkTreeViewColumn *col, GtkCellRenderer *renderer,
                                GtkTreeModel *model, GtkTreeIter *iter, gpointer data) {
-    gchar *status;
-    gtk_tree_model_get(model, iter, 5, &status, -1);
-    
-    const char *color;
-    if (strstr(status, "Alert!") != NULL) {
-        color = "red";
-    } else if (strstr(status, "Warning!") != NULL) {
-        color = "orange";
-    } else {
-        color = "green";
-    }
-    
-    gboolean is_current = FALSE;
-    if (has_current_iter) {
-        GtkTreePath *current_path = gtk_tree_model_get_path(model, &current_iter);
-        GtkTreePath *iter_path = gtk_tree_model_get_path(model, iter);
-        if (gtk_tree_path_compare(current_path, iter_path) == 0) {
-            is_current = TRUE;
-        }
-        gtk_tree_path_free(current_path);
-        gtk_tree_path_free(iter_path);
-    }
-    
+    size_t row = reading_model_iter_row(iter);
     g_object_set(renderer,
-        "foreground", color,
+        "foreground-rgba", &level_colors[reading_model_humid_level(reading_model, row)],
         "weight", PANGO_WEIGHT_BOLD,
-        "background", is_current ? "white" : NULL,
+        "background-rgba", (long long)row == current_row ? &current_row_color : NULL,
         NULL);
-    g_free(status);
 }
 
 // Other columns
 void generic_cell_data_func(GtkTreeViewColumn *col, GtkCellRenderer *renderer,
                            GtkTreeModel *model, GtkTreeIter *iter, gpointer data) {
-
-    gboolean is_current = FALSE;
-    if (has_current_iter) {
-        GtkTreePath *current_path = gtk_tree_model_get_path(model, &current_iter);
-        GtkTreePath *iter_path = gtk_tree_model_get_path(model, iter);
-        if (gtk_tree_path_compare(current_path, iter_path) == 0) {
-            is_current = TRUE;
-        }
-        gtk_tree_path_free(current_path);
-        gtk_tree_path_free(iter_path);
-    }
-    
+    gboolean is_current = (long long)reading_model_iter_row(iter) == current_row;
     g_object_set(renderer,
-        "background", is_current ? "white" : NULL,
+        "background-rgba", is_current ? &current_row_color : NULL,
         "weight", is_current ? PANGO_WEIGHT_BOLD : PANGO_WEIGHT_NORMAL,
         NULL);
 }
 
-void update_gui(int idx) {
+// Moves the highlight, only the two rows involved are redrawn
+static void set_current_row(long long row) {
+    long long previous = current_row;
+    current_row = row;
+    if (previous >= 0 && previous != row) reading_model_row_changed(reading_model, (size_t)previous);
+    if (row >= 0 && row != previous) reading_model_row_changed(reading_model, (size_t)row);
+}
+
+static const char *temp_status_text[] = {
+    "Safe Temperature levels.", "Warning! Safe Temperature exceeding.", "Alert! Safe Temperature exceeded."
+};
+static const char *humid_status_text[] = {
+    "Safe Humidity levels.", "Warning! Safe Humidity exceeding.", "Alert! Safe Humidity exceeded."
+};
+
+// Loads RULES_FILE, or the built-in rules when there is none, and moves the chart bands
+static void load_rules(void) {
+    int error_line;
+    if (!rules_load(&rule_engine, RULES_FILE, &error_line)) {
+        if (error_line > 0) printf("%s:%d: invalid rule, using the built-in rules\n", RULES_FILE, error_line);
+        rules_defaults(&rule_engine);
+    }
+    if (!rules_compile(&rule_engine)) printf("Out of memory compiling the rules\n");
+
+    double warning, alert;
+    if (rules_band(&rule_engine, RULE_TEMP, &warning, &alert) ||
+        rules_band(&rule_engine, RULE_HUMID, &warning, &alert)) {
+        chart_set_thresholds(&readings_chart, warning, alert);
+    }
+}
+
+// Shows the running aggregates, costs the same no matter how many readings were seen
+static void update_live_label(void) {
+    const RunningStats *rs = &live_stats;
+    char scope[48] = "all sensors";
+    if (selected_sensor >= 0 && (size_t)selected_sensor < sensor_set.count) {
+        rs = &sensor_set.shards[selected_sensor]->stats;
+        snprintf(scope, sizeof(scope), "sensor %d", sensor_set.shards[selected_sensor]->id);
+    }
+
+    Statistics snap;
+    running_stats_snapshot(rs, &snap);
+    if (snap.count == 0) {
+        gtk_label_set_text(GTK_LABEL(live_label), "No readings yet.");
+        return;
+    }
+
+    WindowStats trend_temp, trend_humid;
+    window_get(&trend_window, WINDOW_TEMP, &trend_temp);
+    window_get(&trend_window, WINDOW_HUMID, &trend_humid);
+
+    char text[1024];
+    snprintf(text, sizeof(text),
+        "Readings: %lld (%s, %zu sensors)\n"
+        "Temp: avg %.2f °C, std dev %.2f, min %.2f at %s, max %.2f at %s\n"
+        "Humid: avg %.2f %%, std dev %.2f, min %.2f at %s, max %.2f at %s\n"
+        "Last %d h, all sensors (%zu readings): temp avg %.2f, max %.2f, std dev %.2f | humid avg %.2f, max %.2f, std dev %.2f\n"
+        "Alerts: temperature %lld (warnings %lld), humidity %lld (warnings %lld)\n"
+        "Acquisition: %zu queued, %llu waits for the GUI, %llu dropped",
+        snap.count, scope, sensor_set.count,
+        snap.avg_temp, snap.stddev_temp, snap.min_temp, snap.min_temp_ts, snap.max_temp, snap.max_temp_ts,
+        snap.avg_humid, snap.stddev_humid, snap.min_humid, snap.min_humid_ts, snap.max_humid, snap.max_humid_ts,
+        TREND_WINDOW_SECONDS / 3600, trend_temp.count,
+        trend_temp.mean, trend_temp.max, trend_temp.stddev,
+        trend_humid.mean, trend_humid.max, trend_humid.stddev,
+        rs->temp_alerts, rs->temp_warnings,
+        rs->humid_alerts, rs->humid_warnings,
+        ring_count(&acquisition.ring),
+        (unsigned long long)atomic_load(&acquisition.stalls),
+        (unsigned long long)atomic_load(&acquisition.dropped));
+    gtk_label_set_text(GTK_LABEL(live_label), text);
+}
+
+// Status, windows and live aggregates for store rows [first, first + n), n <= ACQUIRE_BATCH.
+// The status values of the block are gathered first and the rules run over all of them
+// at once. No widget is touched here.
+static void process_readings(size_t first, size_t n) {
+    static SensorShard *shards[ACQUIRE_BATCH];
+    static int sensor_ids[ACQUIRE_BATCH];
+    static int64_t epochs[ACQUIRE_BATCH];
+    static double status_temp[ACQUIRE_BATCH], status_humid[ACQUIRE_BATCH];
+    static AlertLevel temp_levels[ACQUIRE_BATCH], humid_levels[ACQUIRE_BATCH];
+
+    for (size_t i = 0; i < n; i++) {
+        size_t idx = first + i;
+        double temperature = store_temperature(&readings, idx);
+        double humidity = store_humidity(&readings, idx);
+
+        // Status follows the moving average of the reading's own sensor (sensors_status)
+        epochs[i] = store_epoch(&readings, idx);
+        sensor_ids[i] = store_sensor_id(&readings, idx);
+        shards[i] = sensors_get(&sensor_set, sensor_ids[i]);
+        window_push(&trend_window, epochs[i], temperature, humidity);
+        sensors_status(shards[i], epochs[i], temperature, humidity, &status_temp[i], &status_humid[i]);
+    }
+
+    /// This is the Main loop that determines temperature and humidity status///
+    rules_eval(&rule_engine, sensor_ids, epochs, status_temp, status_humid, temp_levels, humid_levels, n);
+
+    for (size_t i = 0; i < n; i++) {
+        size_t idx = first + i;
+        double temperature = store_temperature(&readings, idx);
+        double humidity = store_humidity(&readings, idx);
+
+        // O(1) update of the live aggregates, overall and per sensor
+        running_stats_add(&live_stats, epochs[i], temperature, humidity, temp_levels[i], humid_levels[i]);
+        if (shards[i]) {
+            running_stats_add(&shards[i]->stats, epochs[i], temperature, humidity, temp_levels[i], humid_levels[i]);
+            sensors_add(shards[i], &readings, idx);
+        }
+
+        // Only the two levels are stored, the cells are formatted when the row is drawn
+        reading_model_append(reading_model, temp_levels[i], humid_levels[i]);
+    }
+}
+
+// Empties the sensor selector for a new run, only the aggregate view is left
+static void reset_sensor_list(void) {
+    selected_sensor = -1;
+    sensors_listed = 0;
+    gtk_combo_box_text_remove_all(GTK_COMBO_BOX_TEXT(sensor_combo));
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(sensor_combo), "All sensors");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(sensor_combo), 0);
+}
+
+// Offers the sensors seen since the last frame
+static void refresh_sensor_list(void) {
+    for (; sensors_listed < sensor_set.count; sensors_listed++) {
+        char name[32];
+        snprintf(name, sizeof(name), "Sensor %d", sensor_set.shards[sensors_listed]->id);
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(sensor_combo), name);
+    }
+}
+
+// View updates done once per frame, however many readings the frame added
+void update_gui(size_t last) {
     GtkTreeIter iter;
-    gtk_list_store_append(list_store, &iter);
-
-    // Value formatting
-    char temp_str[32], humid_str[32], safe_temp[50], safe_humid[50];
-    sprintf(temp_str, "%.2f °C", readings[idx].temperature);
-    sprintf(humid_str, "%.2f %%", readings[idx].humidity);
-
-    /// This is the Main loop that determines temperature status///
-    if (readings[idx].temperature > ALERT_THRESHOLD)
-        strcpy(safe_temp, "Alert! Safe Temperature exceeded.");
-    else if (readings[idx].temperature >= WARNING_THRESHOLD)
-        strcpy(safe_temp, "Warning! Safe Temperature exceeding.");
-    else
-        strcpy(safe_temp, "Safe Temperature levels.");
-
-    /// This is the Main loop that determines humidity status///
-    if (readings[idx].humidity > ALERT_THRESHOLD)
-        strcpy(safe_humid, "Alert! Safe Humidity exceeded.");
-    else if (readings[idx].humidity >= WARNING_THRESHOLD)
-        strcpy(safe_humid, "Warning! Safe Humidity exceeding.");
-    else
-        strcpy(safe_humid, "Safe Humidity levels.");
-
-    gtk_list_store_set(list_store, &iter,
-        0, readings[idx].seq_no,
-        1, readings[idx].timestamp,
-        2, temp_str,
-        3, humid_str,
-        4, safe_temp,
-        5, safe_humid,
-        -1);
-
-    current_iter = iter;
-    has_current_iter = TRUE;
-
-    GtkTreePath *path = gtk_tree_model_get_path(GTK_TREE_MODEL(list_store), &iter);
+    refresh_sensor_list();
+    update_live_label();
+    set_current_row((long long)last);
+    reading_model_iter(reading_model, last, &iter);
+
+    GtkTreePath *path = gtk_tree_model_get_path(GTK_TREE_MODEL(reading_model), &iter);
     gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(tree_view), path, NULL, FALSE, 0.0, 0.0);
     
     GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(tree_view));
     gtk_tree_selection_select_iter(selection, &iter);
     
     gtk_tree_path_free(path);
+}
 
-    gtk_widget_queue_draw(tree_view);
+// Loads the rollup saved next to the data file if it was built from the file as it is now
+static gboolean load_rollup(const char *data_filename) {
+    char path[300];
+    rollup_path(data_filename, path, sizeof(path));
+    return rollup_matches(path, data_filename) && rollup_load(&readings_rollup, path);
 }
 
-gboolean simulate_reading(gpointer data) {
-    static int idx = 0;
-    if (idx >= selected_log_size) {
-        calc_statistics(readings, selected_log_size, &stats);
-        
-        char stats_msg[512];
-        sprintf(stats_msg,
-            "Simulation Complete!\n\n"
-            "Total Readings: %d\n"
-            "Average Temp: %.2f °C\n"
-            "Average Humid: %.2f %%\n"
-            "Max Temp: %.2f °C at %s\n"
-            "Max Humid: %.2f %% at %s\n",
-            selected_log_size,
-            stats.avg_temp,
-            stats.avg_humid,
-            stats.max_temp, stats.max_temp_ts,
-            stats.max_humid, stats.max_humid_ts
-        );
+// Saves the rollup built during the run next to the data file
+static void save_rollup(const char *data_filename) {
+    char path[300];
+    rollup_path(data_filename, path, sizeof(path));
+    if (!rollup_save(&readings_rollup, path, data_filename)) printf("Could not save %s\n", path);
+}
+
+// Shows the outcome of a run once the drain has taken the last reading
+gboolean finish_simulation(gpointer data) {
+    GtkWidget *start_button = (GtkWidget*)data;
+    AcquireStatus status = (AcquireStatus)atomic_load(&acquisition.status);
+    gboolean whole_file = atomic_load(&acquisition.complete) && atomic_load(&acquisition.dropped) == 0;
+    acquire_join(&acquisition);
+    set_current_row(-1);
+    if (start_button) {
+        gtk_widget_set_sensitive(start_button, TRUE);
+    }
+    gtk_widget_set_sensitive(stop_button, FALSE);
+
+    if (readings.count == 0) {
+        const char *problem = status == ACQUIRE_NO_MEMORY ? "Out of memory!" :
+            input_mode == 4 ? "Binary log error!" :
+            input_mode == 5 ? "Archive error!" : "CSV file error!";
+        char source_hint[300] = "";
+        if (input_mode == 4 || input_mode == 5) {
+            snprintf(source_hint, sizeof(source_hint), " (or '%s')", source_csv_filename);
+        }
         GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
-            GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", stats_msg);
+            GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
+            "%s\nMake sure '%s'%s exists and contains readings.", problem, run_filename ? run_filename : "",
+            source_hint);
         gtk_dialog_run(GTK_DIALOG(dialog));
         gtk_widget_destroy(dialog);
-        
-        has_current_iter = FALSE;
-        gtk_widget_queue_draw(tree_view);
-        
-        GtkWidget *start_button = (GtkWidget*)data;
-        if (start_button) {
-            gtk_widget_set_sensitive(start_button, TRUE);
-        }
-        
-        idx = 0;
-        return FALSE;
+        return G_SOURCE_REMOVE;
     }
+
+    // Files shorter than the requested count are shown as far as they go
+    if (run_filename && input_mode != 6 && readings.count < (size_t)selected_log_size) {
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(readings_spinner), (double)readings.count);
+        selected_log_size = (int)readings.count;
+    }
+
+    // Range queries cover everything loaded, the default range is the whole log
+    char range_ts[TIMESTAMP_LEN];
+    timestamp_format(store_epoch(&readings, 0), range_ts);
+    gtk_entry_set_text(GTK_ENTRY(query_from_entry), range_ts);
+    timestamp_format(store_epoch(&readings, readings.count - 1), range_ts);
+    gtk_entry_set_text(GTK_ENTRY(query_to_entry), range_ts);
+    // A pyramid from part of the file would pass for the whole file next time
+    if (run_filename && !rollup_from_file && whole_file) save_rollup(run_filename);
+    update_live_label();
+
+    calc_statistics_parallel(&readings, 0, &stats);  // One thread per CPU
     
-    update_gui(idx);
-    idx++;
-    return TRUE;
+    char stats_msg[1024];
+    snprintf(stats_msg, sizeof(stats_msg),
+        "Simulation Complete!\n\n"
+        "Total Readings: %lld from %zu sensors\n"
+        "Average Temp: %.2f °C (std dev %.2f)\n"
+        "Average Humid: %.2f %% (std dev %.2f)\n"
+        "Max Temp: %.2f °C at %s\n"
+        "Min Temp: %.2f °C at %s\n"
+        "Max Humid: %.2f %% at %s\n"
+        "Min Humid: %.2f %% at %s\n",
+        stats.count, sensor_set.count,
+        stats.avg_temp, stats.stddev_temp,
+        stats.avg_humid, stats.stddev_humid,
+        stats.max_temp, stats.max_temp_ts,
+        stats.min_temp, stats.min_temp_ts,
+        stats.max_humid, stats.max_humid_ts,
+        stats.min_humid, stats.min_humid_ts
+    );
+    GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+        GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", stats_msg);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+    return G_SOURCE_REMOVE;
+}
+
+// Frame clock tick: drains everything the worker queued since the last frame in one
+// batch, stopping early when the frame budget is used up so drawing keeps its frame rate.
+// Only this thread writes the store, the worker never touches it.
+gboolean drain_readings(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+    static RingSample batch[ACQUIRE_BATCH];
+    uint64_t frame_start = INSTRUMENT_NOW();
+    size_t first = readings.count;
+    double deadline = monotonic_seconds() + FRAME_BUDGET_SECONDS;
+    bool stored = true;
+    size_t n;
+
+    while (stored && (n = acquire_pop(&acquisition, batch, ACQUIRE_BATCH)) > 0) {
+        size_t batch_first = readings.count;
+        for (size_t i = 0; i < n && stored; i++) {
+            stored = store_append_sensor(&readings, batch[i].seq_no, batch[i].epoch, batch[i].temperature,
+                                         batch[i].humidity, batch[i].sensor_id);
+        }
+        process_readings(batch_first, readings.count - batch_first);
+        if (monotonic_seconds() > deadline) break;
+    }
+    if (!stored) acquire_cancel(&acquisition);  // Out of memory, keep what was shown
+
+    if (readings.count > first) {
+        tindex_update(&readings_index, &readings);
+        if (!rollup_from_file) rollup_add_store(&readings_rollup, &readings, first);
+        chart_append(&readings_chart);
+        update_gui(readings.count - 1);
+
+        uint64_t shown = INSTRUMENT_NOW();
+        INSTRUMENT_RECORD(PROBE_GUI_FRAME, shown - frame_start);
+        INSTRUMENT_RECORD(PROBE_GUI_ROW, (shown - frame_start) / (readings.count - first));
+    }
+
+    // Every push whose readings were all handled in this frame reaches the screen with it
+    uint64_t pushed_ns;
+    while (INSTRUMENT_COMPILED && acquire_take_mark(&acquisition, &pushed_ns)) {
+        INSTRUMENT_RECORD(PROBE_SAMPLE_TO_SCREEN, INSTRUMENT_NOW() - pushed_ns);
+    }
+
+    if (acquire_finished(&acquisition)) {
+        acquisition_active = FALSE;
+        drain_tick = 0;
+        g_idle_add(finish_simulation, data);  // Dialogs must not run inside a frame
+        return G_SOURCE_REMOVE;
+    }
+    if (ring_count(&acquisition.ring) == 0) {
+        // Nothing queued, stop ticking until the worker wakes the main loop again
+        drain_tick = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Readings are waiting and no frame is scheduled to drain them
+static gboolean acquisition_pending(void) {
+    return acquisition_active && drain_tick == 0 &&
+           (ring_count(&acquisition.ring) > 0 || atomic_load(&acquisition.done));
+}
+
+static gboolean acquisition_prepare(GSource *source, gint *timeout) {
+    *timeout = -1;
+    return acquisition_pending();
+}
+
+static gboolean acquisition_check(GSource *source) {
+    return acquisition_pending();
+}
+
+static gboolean acquisition_dispatch(GSource *source, GSourceFunc callback, gpointer data) {
+    return callback(data);
+}
+
+// Main loop source for the acquisition ring, polled whenever the loop wakes up
+static GSourceFuncs acquisition_source_funcs = {
+    acquisition_prepare, acquisition_check, acquisition_dispatch, NULL
+};
+
+// Readings arrived while idle: drain them with the next frame
+static gboolean on_readings_queued(gpointer data) {
+    drain_tick = gtk_widget_add_tick_callback(tree_view, drain_readings, data, NULL);
+    return G_SOURCE_CONTINUE;
+}
+
+// Runs on the acquisition thread, only interrupts the main loop's poll
+static void wake_main_loop(void *user_data) {
+    g_main_context_wakeup(NULL);
 }
 
 void start_simulation(GtkWidget *widget, gpointer data) {
+    AcquireSource source;
+    size_t max = (size_t)selected_log_size;
+    int interval_ms = update_interval_ms;
+
+    // The table reads from the store, so it is emptied before the store is.
+    // Detached while clearing, otherwise the view would process every removed row.
+    current_row = -1;
+    gtk_tree_view_set_model(GTK_TREE_VIEW(tree_view), NULL);
+    reading_model_reset(reading_model);
+    gtk_tree_view_set_model(GTK_TREE_VIEW(tree_view), GTK_TREE_MODEL(reading_model));
+    store_clear(&readings);
+    tindex_reset(&readings_index);
+    rollup_reset(&readings_rollup);
+    chart_reset(&readings_chart);
+    load_rules();  // Edits to the rules file apply from the next run
+
     if (input_mode == 1) {
         // Mode 1: Generate random temperature and humidity readings
-        generate_random_readings(readings, selected_log_size);
+        source = ACQUIRE_RANDOM;
+        run_filename = NULL;
+    } else if (input_mode == 4) {
+        // Mode 4: Memory-mapped binary log, records are copied without any parsing
+        source = ACQUIRE_BINLOG;
+        run_filename = bin_filename;
+    } else if (input_mode == 5) {
+        // Mode 5: Compressed archive, decoded one block at a time
+        source = ACQUIRE_ARCHIVE;
+        run_filename = archive_filename;
+    } else if (input_mode == 6) {
+        // Mode 6: Follow readings.csv while a logger appends to it, until Stop is pressed.
+        // The file itself buffers the readings, so they are shown as soon as they are written.
+        strcpy(csv_filename, "readings.csv");
+        source = ACQUIRE_TAIL;
+        run_filename = csv_filename;
+        max = SIZE_MAX;
+        interval_ms = 0;
     } else {
         // Mode 2 or 3: Load data from CSV files
         // Mode 3: Test CSV (test_readings.csv) - user-generated test data
         const char* filename = (input_mode == 3) ? "test_readings.csv" : "readings.csv";
         strcpy(csv_filename, filename);
-        
-        if (!read_csv_readings(csv_filename, readings, selected_log_size)) {
-            GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
-                GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE, 
-                "CSV file error!\nMake sure '%s' exists and has enough data.", csv_filename);
-            gtk_dialog_run(GTK_DIALOG(dialog));
-            gtk_widget_destroy(dialog);
-            return;
-        }
+        source = ACQUIRE_CSV;
+        run_filename = csv_filename;
+    }
+
+    // Overviews of an unchanged file come from its saved pyramid, covering the whole
+    // file however few readings this run shows; a followed file keeps growing
+    rollup_from_file = run_filename && source != ACQUIRE_TAIL && load_rollup(run_filename);
+    if (rollup_from_file) printf("Loaded the rollup of %s\n", run_filename);
+
+    running_stats_reset(&live_stats);
+    sensors_clear(&sensor_set, (size_t)status_window_size);
+    window_reset(&trend_window);
+    reset_sensor_list();
+    instrument_reset();  // The panel shows the current run
+    // Same seed and settings replay the same random readings
+    workload_defaults(&acquisition.workload);
+    acquisition.workload.sensors = sensor_count;
+    acquisition.workload.seed = random_seed ? (uint64_t)random_seed : workload_clock_seed();
+
+    // Reading and parsing happen on the acquisition thread, readings reach the
+    // GUI through the ring and are shown once per frame as they arrive
+    if (!acquire_start(&acquisition, source, run_filename, source_csv_filename, max, interval_ms, wake_main_loop, NULL)) {
+        GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+            GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE, "Could not start the acquisition thread.");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        return;
     }
-    
     gtk_widget_set_sensitive(widget, FALSE);
-    gtk_list_store_clear(list_store);
-    
-    has_current_iter = FALSE;
-    
-    // Dummy timeout
-    g_timeout_add(500, simulate_reading, widget);
+    gtk_widget_set_sensitive(stop_button, TRUE);
+    acquisition_active = TRUE;
+    update_live_label();
+}
+
+// Ends the run early, readings already queued are still shown
+static void stop_simulation(GtkWidget *widget, gpointer data) {
+    acquire_cancel(&acquisition);
+}
+
+// Statistics for the time range typed into the query entries
+static void on_range_query(GtkWidget *widget, gpointer data) {
+    const char *from_text = gtk_entry_get_text(GTK_ENTRY(query_from_entry));
+    const char *to_text = gtk_entry_get_text(GTK_ENTRY(query_to_entry));
+    int64_t from, to;
+    size_t len;
+    char msg[1024];
+
+    if (!timestamp_parse(from_text, strlen(from_text), &from, &len) ||
+        !timestamp_parse(to_text, strlen(to_text), &to, &len)) {
+        GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+            GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
+            "Invalid time range!\nUse the format YYYY-MM-DD HH:MM for both ends.");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        return;
+    }
+
+    // The selected sensor is answered from its shard, all sensors from the time index
+    Statistics range;
+    char scope[48] = "";
+    if (selected_sensor >= 0 && (size_t)selected_sensor < sensor_set.count) {
+        const SensorShard *shard = sensor_set.shards[selected_sensor];
+        sensors_range_stats(shard, &readings, from, to, &range);
+        snprintf(scope, sizeof(scope), "Sensor %d: ", shard->id);
+    } else {
+        tindex_query(&readings_index, &readings, from, to, &range);
+    }
+    if (range.count == 0) {
+        snprintf(msg, sizeof(msg), "%sNo readings between %s and %s.", scope, from_text, to_text);
+    } else {
+        snprintf(msg, sizeof(msg),
+            "%sReadings between %s and %s: %lld\n\n"
+            "Average Temp: %.2f °C (std dev %.2f)\n"
+            "Average Humid: %.2f %% (std dev %.2f)\n"
+            "Max Temp: %.2f °C at %s\n"
+            "Min Temp: %.2f °C at %s\n"
+            "Max Humid: %.2f %% at %s\n"
+            "Min Humid: %.2f %% at %s\n",
+            scope, from_text, to_text, range.count,
+            range.avg_temp, range.stddev_temp,
+            range.avg_humid, range.stddev_humid,
+            range.max_temp, range.max_temp_ts,
+            range.min_temp, range.min_temp_ts,
+            range.max_humid, range.max_humid_ts,
+            range.min_humid, range.min_humid_ts);
+    }
+
+    GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+        GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", msg);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+// Lists the query range from the rollup pyramid, at the finest level that fits OVERVIEW_ROWS rows
+static void on_range_overview(GtkWidget *widget, gpointer data) {
+    const char *from_text = gtk_entry_get_text(GTK_ENTRY(query_from_entry));
+    const char *to_text = gtk_entry_get_text(GTK_ENTRY(query_to_entry));
+    int64_t from, to;
+    size_t len;
+
+    if (!timestamp_parse(from_text, strlen(from_text), &from, &len) ||
+        !timestamp_parse(to_text, strlen(to_text), &to, &len) || from > to) {
+        GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+            GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
+            "Invalid time range!\nUse the format YYYY-MM-DD HH:MM for both ends.");
+        gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+        return;
+    }
+
+    static const char *level_names[] = { "Minute", "Hour", "Day" };
+    RollupLevel level = rollup_pick_level(from, to, OVERVIEW_ROWS);
+    size_t n;
+    const RollupBucket *rows = rollup_range(&readings_rollup, level, from, to, &n);
+    RollupBucket total;
+    rollup_summary(&readings_rollup, from, to, &total);
+
+    char text[8192];
+    int used = snprintf(text, sizeof(text), "%s overview, %zu rows\n\n", level_names[level], n);
+    for (size_t i = 0; i < n && i < OVERVIEW_ROWS && used < (int)sizeof(text); i++) {
+        char ts[TIMESTAMP_LEN];
+        timestamp_format(rows[i].start, ts);
+        used += snprintf(text + used, sizeof(text) - used,
+            "%s  (%llu)  temp %.1f / %.1f / %.1f  humid %.1f / %.1f / %.1f\n",
+            ts, (unsigned long long)rows[i].count,
+            rows[i].temp.min, rows[i].temp.sum / rows[i].count, rows[i].temp.max,
+            rows[i].humid.min, rows[i].humid.sum / rows[i].count, rows[i].humid.max);
+    }
+    if (total.count > 0 && used < (int)sizeof(text)) {
+        snprintf(text + used, sizeof(text) - used,
+            "\nWhole range (%llu readings): temp %.1f / %.1f / %.1f  humid %.1f / %.1f / %.1f\n"
+            "(min / avg / max)",
+            (unsigned long long)total.count,
+            total.temp.min, total.temp.sum / total.count, total.temp.max,
+            total.humid.min, total.humid.sum / total.count, total.humid.max);
+    }
+
+    GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL,
+        GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", text);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
 }
 
 //From here on downwards the code mainly focused on GUI styling and layout
@@ -242,9 +635,68 @@ static void on_readings_count_changed(GtkSpinButton *spin_button, gpointer user_
     printf("Number of readings set to: %d\n", selected_log_size);
 }
 
+static void on_interval_changed(GtkSpinButton *spin_button, gpointer user_data) {
+    update_interval_ms = (int)gtk_spin_button_get_value(spin_button);
+    acquire_set_interval(&acquisition, update_interval_ms);  // Also applies to a run in progress
+    if (update_interval_ms == 0) {
+        printf("Update interval set to: as fast as possible\n");
+    } else {
+        printf("Update interval set to: %d ms\n", update_interval_ms);
+    }
+}
+
+static void on_sensors_count_changed(GtkSpinButton *spin_button, gpointer user_data) {
+    sensor_count = (int)gtk_spin_button_get_value(spin_button);
+    printf("Simulated sensors set to: %d\n", sensor_count);
+}
+
+static void on_seed_changed(GtkSpinButton *spin_button, gpointer user_data) {
+    random_seed = (int)gtk_spin_button_get_value(spin_button);
+    if (random_seed == 0) {
+        printf("Random seed set to: new each run\n");
+    } else {
+        printf("Random seed set to: %d\n", random_seed);
+    }
+}
+
+// Switches the live panel and range queries between one sensor and all of them
+static void on_sensor_changed(GtkComboBox *combo, gpointer user_data) {
+    int active = gtk_combo_box_get_active(combo);
+    selected_sensor = active > 0 ? active - 1 : -1;
+    update_live_label();
+}
+
+static void on_status_window_changed(GtkSpinButton *spin_button, gpointer user_data) {
+    status_window_size = (int)gtk_spin_button_get_value(spin_button);
+    printf("Status window set to: %d readings\n", status_window_size);
+}
+
+// Shows the hot-path timings, merged from every thread
+static gboolean refresh_instrument_panel(gpointer data) {
+    char report[INSTRUMENT_REPORT_SIZE];
+    instrument_report(report, sizeof(report));
+    gchar *markup = g_markup_printf_escaped("<tt>%s</tt>", report);
+    gtk_label_set_markup(GTK_LABEL(instrument_label), markup);
+    g_free(markup);
+    return G_SOURCE_CONTINUE;
+}
+
+// Periodic copy of the panel, for runs nobody is watching
+static gboolean dump_instrumentation(gpointer data) {
+    if (instrument_enabled() && !instrument_dump(INSTRUMENT_LOG)) {
+        printf("Could not write %s\n", INSTRUMENT_LOG);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_instrument_toggled(GtkToggleButton *toggle, gpointer user_data) {
+    instrument_set_enabled(gtk_toggle_button_get_active(toggle));
+    printf("Instrumentation %s\n", gtk_toggle_button_get_active(toggle) ? "enabled" : "disabled");
+}
+
 static void on_dropdown_changed(GtkComboBox *combo, gpointer user_data) {
     input_mode = gtk_combo_box_get_active(combo) + 1;
-    const char* mode_names[] = {"Random Generator", "Default CSV File", "Test CSV File"};
+    const char* mode_names[] = {"Random Generator", "Default CSV File", "Test CSV File", "Binary Log File", "Compressed Archive", "Live Tail"};
     printf("Input mode set to: %s\n", mode_names[input_mode - 1]);
     
     if (input_mode == 3) {
@@ -252,21 +704,31 @@ static void on_dropdown_changed(GtkComboBox *combo, gpointer user_data) {
         selected_log_size = 5;
         gtk_spin_button_set_value(GTK_SPIN_BUTTON(readings_spinner), 5);
         printf("Readings automatically set to 5 for Test CSV File mode\n");
+
+        // Test readings are checked one by one against the expected status
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(status_window_spinner), 1);
     } else {
-        gtk_spin_button_set_range(GTK_SPIN_BUTTON(readings_spinner), 1, 50);
-        selected_log_size = 50;
-        gtk_spin_button_set_value(GTK_SPIN_BUTTON(readings_spinner), 50);
-        printf("Readings automatically set to 50 for %s mode\n", mode_names[input_mode - 1]);
+        gtk_spin_button_set_range(GTK_SPIN_BUTTON(readings_spinner), 1, MAX_LOG_SIZE);
+        selected_log_size = DEFAULT_LOG_SIZE;
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(readings_spinner), DEFAULT_LOG_SIZE);
+        printf("Readings automatically set to %d for %s mode\n", DEFAULT_LOG_SIZE, mode_names[input_mode - 1]);
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(status_window_spinner), STATUS_WINDOW_SIZE);
     }
 }
 
 void build_gui() {
     GtkWidget *window, *main_vbox, *control_panel, *control_grid, *scrolled, *button, *dropdown, *header, *headerbar;
-    GtkWidget *readings_label, *mode_label;
+    GtkWidget *readings_label, *mode_label, *live_frame, *status_window_label, *interval_label;
+    GtkWidget *sensors_label, *seed_label, *sensor_label;
+    GtkWidget *query_frame, *query_box, *query_button, *overview_button;
+    GtkWidget *instrument_frame, *instrument_box, *instrument_toggle;
+    GtkWidget *views, *chart_area;
     GtkCellRenderer *renderer;
     GtkTreeViewColumn *col;
 
     gtk_init(NULL, NULL);
+    for (int i = 0; i < 3; i++) gdk_rgba_parse(&level_colors[i], level_color_names[i]);
+    gdk_rgba_parse(&current_row_color, "white");
     window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
     gtk_window_set_title(GTK_WINDOW(window), "Temperature & Humidity Logger");
     gtk_window_set_default_size(GTK_WINDOW(window), 900, 600);
@@ -299,7 +761,7 @@ void build_gui() {
     readings_label = gtk_label_new("Number of Readings:");
     gtk_grid_attach(GTK_GRID(control_grid), readings_label, 0, 0, 1, 1);
     
-    readings_spinner = gtk_spin_button_new_with_range(1, 50, 1);
+    readings_spinner = gtk_spin_button_new_with_range(1, MAX_LOG_SIZE, 1);
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(readings_spinner), selected_log_size);
     gtk_grid_attach(GTK_GRID(control_grid), readings_spinner, 1, 0, 1, 1);
 
@@ -310,25 +772,118 @@ void build_gui() {
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Random Generator");
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Default CSV File");
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Test CSV File");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Binary Log File");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Compressed Archive");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(dropdown), "Live Tail");
     gtk_combo_box_set_active(GTK_COMBO_BOX(dropdown), 0);
     gtk_grid_attach(GTK_GRID(control_grid), dropdown, 1, 1, 1, 1);
 
-    button = gtk_button_new_with_label("Start Simulation");
-    gtk_grid_attach(GTK_GRID(control_grid), button, 0, 2, 2, 1);
+    status_window_label = gtk_label_new("Status Window (readings):");
+    gtk_grid_attach(GTK_GRID(control_grid), status_window_label, 0, 2, 1, 1);
+
+    status_window_spinner = gtk_spin_button_new_with_range(1, MAX_STATUS_WINDOW, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(status_window_spinner), status_window_size);
+    gtk_grid_attach(GTK_GRID(control_grid), status_window_spinner, 1, 2, 1, 1);
+
+    interval_label = gtk_label_new("Update Interval (ms, 0 = max):");
+    gtk_grid_attach(GTK_GRID(control_grid), interval_label, 0, 3, 1, 1);
+
+    interval_spinner = gtk_spin_button_new_with_range(0, MAX_UPDATE_INTERVAL, 50);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(interval_spinner), update_interval_ms);
+    gtk_grid_attach(GTK_GRID(control_grid), interval_spinner, 1, 3, 1, 1);
+
+    sensors_label = gtk_label_new("Simulated Sensors:");
+    gtk_grid_attach(GTK_GRID(control_grid), sensors_label, 0, 4, 1, 1);
 
-    list_store = gtk_list_store_new(6, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    sensors_spinner = gtk_spin_button_new_with_range(1, MAX_SIMULATED_SENSORS, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(sensors_spinner), sensor_count);
+    gtk_grid_attach(GTK_GRID(control_grid), sensors_spinner, 1, 4, 1, 1);
 
-    tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(list_store));
+    seed_label = gtk_label_new("Random Seed (0 = clock):");
+    gtk_grid_attach(GTK_GRID(control_grid), seed_label, 0, 5, 1, 1);
+
+    seed_spinner = gtk_spin_button_new_with_range(0, MAX_RANDOM_SEED, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(seed_spinner), random_seed);
+    gtk_grid_attach(GTK_GRID(control_grid), seed_spinner, 1, 5, 1, 1);
+
+    sensor_label = gtk_label_new("Show Sensor:");
+    gtk_grid_attach(GTK_GRID(control_grid), sensor_label, 0, 6, 1, 1);
+
+    sensor_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(sensor_combo), "All sensors");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(sensor_combo), 0);
+    gtk_grid_attach(GTK_GRID(control_grid), sensor_combo, 1, 6, 1, 1);
+
+    button = gtk_button_new_with_label("Start Simulation");
+    gtk_grid_attach(GTK_GRID(control_grid), button, 0, 7, 2, 1);
+
+    stop_button = gtk_button_new_with_label("Stop");
+    gtk_widget_set_sensitive(stop_button, FALSE);
+    gtk_grid_attach(GTK_GRID(control_grid), stop_button, 0, 8, 2, 1);
+
+    live_frame = gtk_frame_new("Live Statistics");
+    gtk_box_pack_start(GTK_BOX(main_vbox), live_frame, FALSE, FALSE, 0);
+    live_label = gtk_label_new("No readings yet.");
+    gtk_label_set_xalign(GTK_LABEL(live_label), 0.0);
+    gtk_widget_set_margin_start(live_label, 15);
+    gtk_widget_set_margin_top(live_label, 5);
+    gtk_widget_set_margin_bottom(live_label, 5);
+    gtk_container_add(GTK_CONTAINER(live_frame), live_label);
+
+    instrument_frame = gtk_frame_new("Instrumentation");
+    gtk_box_pack_start(GTK_BOX(main_vbox), instrument_frame, FALSE, FALSE, 0);
+    instrument_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(instrument_box), 5);
+    gtk_container_add(GTK_CONTAINER(instrument_frame), instrument_box);
+    instrument_toggle = gtk_check_button_new_with_label("Record timings (dumped to " INSTRUMENT_LOG ")");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(instrument_toggle), instrument_enabled());
+    gtk_widget_set_sensitive(instrument_toggle, INSTRUMENT_COMPILED);
+    gtk_box_pack_start(GTK_BOX(instrument_box), instrument_toggle, FALSE, FALSE, 0);
+    instrument_label = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(instrument_label), 0.0);
+    gtk_widget_set_margin_start(instrument_label, 10);
+    gtk_box_pack_start(GTK_BOX(instrument_box), instrument_label, FALSE, FALSE, 0);
+    refresh_instrument_panel(NULL);
+
+    query_frame = gtk_frame_new("Range Query");
+    gtk_box_pack_start(GTK_BOX(main_vbox), query_frame, FALSE, FALSE, 0);
+    query_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(query_box), 10);
+    gtk_container_add(GTK_CONTAINER(query_frame), query_box);
+    gtk_box_pack_start(GTK_BOX(query_box), gtk_label_new("From:"), FALSE, FALSE, 0);
+    query_from_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(query_from_entry), "YYYY-MM-DD HH:MM");
+    gtk_box_pack_start(GTK_BOX(query_box), query_from_entry, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(query_box), gtk_label_new("To:"), FALSE, FALSE, 0);
+    query_to_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(query_to_entry), "YYYY-MM-DD HH:MM");
+    gtk_box_pack_start(GTK_BOX(query_box), query_to_entry, FALSE, FALSE, 0);
+    query_button = gtk_button_new_with_label("Query");
+    gtk_box_pack_start(GTK_BOX(query_box), query_button, FALSE, FALSE, 0);
+    overview_button = gtk_button_new_with_label("Overview");
+    gtk_box_pack_start(GTK_BOX(query_box), overview_button, FALSE, FALSE, 0);
+
+    reading_model = reading_model_new(&readings, temp_status_text, humid_status_text);
+
+    tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(reading_model));
     gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(tree_view), TRUE);
 
-    const char *titles[] = {"Seq\t\t", "Timestamp\t\t", "Temperature (C)", "Humidity (%)\t", "Temperature Status\t\t\t\t\t\t", "Humidity Status"};
-    for (int i = 0; i < 6; i++) {
+    const char *titles[] = {"Seq\t\t", "Sensor", "Timestamp\t\t", "Temperature (C)", "Humidity (%)\t", "Temperature Status\t\t\t\t\t\t", "Humidity Status"};
+    const int columns[] = {READING_COL_SEQ, READING_COL_SENSOR, READING_COL_TIMESTAMP, READING_COL_TEMPERATURE,
+                           READING_COL_HUMIDITY, READING_COL_TEMP_STATUS, READING_COL_HUMID_STATUS};
+    const int widths[] = {70, 70, 150, 130, 120, 300, 260};
+    for (int i = 0; i < 7; i++) {
         renderer = gtk_cell_renderer_text_new();
-        col = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        col = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", columns[i], NULL);
+
+        // Fixed sizing lets GTK skip measuring every row, only visible rows get formatted
+        gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(col, widths[i]);
+        gtk_tree_view_column_set_resizable(col, TRUE);
         
-        if (i == 4) {
+        if (columns[i] == READING_COL_TEMP_STATUS) {
             gtk_tree_view_column_set_cell_data_func(col, renderer, temp_status_cell_data_func, NULL, NULL);
-        } else if (i == 5) {
+        } else if (columns[i] == READING_COL_HUMID_STATUS) {
             gtk_tree_view_column_set_cell_data_func(col, renderer, humid_status_cell_data_func, NULL, NULL);
         } else {
             gtk_tree_view_column_set_cell_data_func(col, renderer, generic_cell_data_func, NULL, NULL);
@@ -337,16 +892,44 @@ void build_gui() {
         gtk_tree_view_append_column(GTK_TREE_VIEW(tree_view), col);
     }
 
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(tree_view), TRUE);
+
     scrolled = gtk_scrolled_window_new(NULL, NULL);
     gtk_container_add(GTK_CONTAINER(scrolled), tree_view);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_widget_set_vexpand(scrolled, TRUE);
     gtk_widget_set_hexpand(scrolled, TRUE);
-    gtk_box_pack_start(GTK_BOX(main_vbox), scrolled, TRUE, TRUE, 0);
+
+    // Chart above the table, the divider can be dragged. Wheel zooms the chart,
+    // dragging pans and a double click shows the whole run again.
+    chart_area = chart_init(&readings_chart, &readings, &readings_rollup, RULE_DEFAULT_WARNING,
+                            RULE_DEFAULT_ALERT);
+    load_rules();
+    views = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
+    gtk_paned_pack1(GTK_PANED(views), chart_area, FALSE, FALSE);
+    gtk_paned_pack2(GTK_PANED(views), scrolled, TRUE, FALSE);
+    gtk_box_pack_start(GTK_BOX(main_vbox), views, TRUE, TRUE, 0);
     g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
     g_signal_connect(button, "clicked", G_CALLBACK(start_simulation), NULL);
+    g_signal_connect(stop_button, "clicked", G_CALLBACK(stop_simulation), NULL);
+    g_signal_connect(query_button, "clicked", G_CALLBACK(on_range_query), NULL);
+    g_signal_connect(overview_button, "clicked", G_CALLBACK(on_range_overview), NULL);
     g_signal_connect(dropdown, "changed", G_CALLBACK(on_dropdown_changed), NULL);
     g_signal_connect(readings_spinner, "value-changed", G_CALLBACK(on_readings_count_changed), NULL);
+    g_signal_connect(status_window_spinner, "value-changed", G_CALLBACK(on_status_window_changed), NULL);
+    g_signal_connect(sensors_spinner, "value-changed", G_CALLBACK(on_sensors_count_changed), NULL);
+    g_signal_connect(seed_spinner, "value-changed", G_CALLBACK(on_seed_changed), NULL);
+    g_signal_connect(sensor_combo, "changed", G_CALLBACK(on_sensor_changed), NULL);
+    g_signal_connect(interval_spinner, "value-changed", G_CALLBACK(on_interval_changed), NULL);
+    g_signal_connect(instrument_toggle, "toggled", G_CALLBACK(on_instrument_toggled), NULL);
+    g_timeout_add(INSTRUMENT_PANEL_MS, refresh_instrument_panel, NULL);
+    if (INSTRUMENT_COMPILED) g_timeout_add_seconds(INSTRUMENT_DUMP_SECONDS, dump_instrumentation, NULL);
+
+    // Woken by the acquisition thread through g_main_context_wakeup()
+    GSource *ring_source = g_source_new(&acquisition_source_funcs, sizeof(GSource));
+    g_source_set_callback(ring_source, on_readings_queued, button, NULL);
+    g_source_attach(ring_source, NULL);
+    g_source_unref(ring_source);
 
     gtk_widget_show_all(window);
     gtk_main();
@@ -358,9 +941,25 @@ int main(int argc, char *argv[]) {
     printf("Available input modes:\n");
     printf("  1. Random Generator\n");
     printf("  2. Default CSV File (readings.csv)\n");
-    printf("  3. Test CSV File (test_readings.csv)\n\n");
+    printf("  3. Test CSV File (test_readings.csv)\n");
+    printf("  4. Binary Log File (readings.bin)\n");
+    printf("  5. Compressed Archive (readings.thz)\n");
+    printf("  6. Live Tail (follows readings.csv as it grows)\n\n");
     
+    sensors_init(&sensor_set, (size_t)status_window_size);
+    window_init(&trend_window, 0, TREND_WINDOW_SECONDS);
+    tindex_init(&readings_index);
+    rollup_init(&readings_rollup);
+    rules_init(&rule_engine);
+    if (!acquire_init(&acquisition, ACQUIRE_RING_CAPACITY)) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
     // Launch the graphical user interface
     build_gui();
+    acquire_free(&acquisition);  // Stops a run still going when the window was closed
+    chart_free(&readings_chart);
+    rules_free(&rule_engine);
     return 0;
 }
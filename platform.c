@@ -0,0 +1,203 @@
+// platform.c - Cross-platform file mapping and timing helpers
+
+#include "platform.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2     // GetProcessMemoryInfo from kernel32, no psapi.lib needed
+#include <windows.h>
+#include <io.h>
+#include <psapi.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maps a whole file read-only into memory, returns false if it cannot be opened
+bool map_file(const char *filename, MappedFile *mf) {
+    memset(mf, 0, sizeof(*mf));
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    mf->size = (size_t)size.QuadPart;
+
+    // Windows cannot map an empty file, so an empty file has no mapping at all
+    if (mf->size > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            mf->data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);  // The view keeps the mapping alive
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    mf->size = (size_t)st.st_size;
+
+    if (mf->size > 0) {
+        void *p = mmap(NULL, mf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, mf->size, MADV_SEQUENTIAL);  // Mostly read front to back
+            mf->data = (const char *)p;
+        }
+    }
+    close(fd);
+#endif
+
+    return mf->size == 0 || mf->data != NULL;
+}
+
+void unmap_file(MappedFile *mf) {
+    if (mf->data) {
+#ifdef _WIN32
+        UnmapViewOfFile((LPCVOID)mf->data);
+#else
+        munmap((void *)mf->data, mf->size);
+#endif
+    }
+    memset(mf, 0, sizeof(*mf));
+}
+
+// Wall clock seconds from an arbitrary fixed point, used for throughput timing
+double monotonic_seconds(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Number of logical processors available to the process (at least 1)
+int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Suspends the calling thread for about ms milliseconds
+void sleep_ms(int ms) {
+    if (ms <= 0) return;
+#ifdef _WIN32
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) {}  // Resumes after a signal
+#endif
+}
+
+// Largest resident set (working set) of the process so far in bytes, 0 if unknown
+size_t peak_rss_bytes(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (size_t)pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)ru.ru_maxrss;          // Bytes on macOS
+#else
+    return (size_t)ru.ru_maxrss * 1024;   // Kilobytes on Linux
+#endif
+#endif
+}
+
+// Breaks t down in the local timezone, thread-safe on every platform
+bool platform_localtime(time_t t, struct tm *out) {
+#ifdef _WIN32
+    return localtime_s(out, &t) == 0;
+#else
+    return localtime_r(&t, out) != NULL;
+#endif
+}
+
+// Size and modification time (seconds) of a file, enough to notice that it changed
+bool file_stamp(const char *filename, uint64_t *size, int64_t *mtime) {
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_stat64(filename, &st) != 0) return false;
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) return false;
+#endif
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+#ifdef _WIN32
+static bool handle_id(HANDLE h, FileId *id) {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(h, &info)) return false;
+    id->volume = info.dwVolumeSerialNumber;
+    id->index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    return true;
+}
+#endif
+
+// Identity of the file currently found under filename, changes when it is replaced
+bool file_id(const char *filename, FileId *id) {
+#ifdef _WIN32
+    HANDLE h = CreateFileA(filename, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    bool ok = handle_id(h, id);
+    CloseHandle(h);
+    return ok;
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) return false;
+    id->volume = (uint64_t)st.st_dev;
+    id->index = (uint64_t)st.st_ino;
+    return true;
+#endif
+}
+
+// Identity of an already open file, whatever its name is now
+bool file_id_open(FILE *file, FileId *id) {
+#ifdef _WIN32
+    intptr_t h = _get_osfhandle(_fileno(file));
+    return h != -1 && handle_id((HANDLE)h, id);
+#else
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) return false;
+    id->volume = (uint64_t)st.st_dev;
+    id->index = (uint64_t)st.st_ino;
+    return true;
+#endif
+}
+
+bool file_id_equal(const FileId *a, const FileId *b) {
+    return a->volume == b->volume && a->index == b->index;
+}
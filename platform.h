@@ -0,0 +1,39 @@
+// platform.h - Declaration of platform.c functions and structures
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Declaration of structure describing a read-only memory-mapped file
+typedef struct {
+    const char *data;   // First byte of the mapping (NULL for an empty file)
+    size_t size;        // File size in bytes
+    void *handle;       // OS specific mapping handle
+} MappedFile;
+
+// Declaration of structure naming a file independently of its path: device and inode,
+// or the volume serial and file index on Windows
+typedef struct {
+    uint64_t volume;
+    uint64_t index;
+} FileId;
+
+// Declaration of required functions
+bool map_file(const char *filename, MappedFile *mf);
+void unmap_file(MappedFile *mf);
+double monotonic_seconds(void);
+int cpu_count(void);
+void sleep_ms(int ms);
+size_t peak_rss_bytes(void);
+bool platform_localtime(time_t t, struct tm *out);
+bool file_stamp(const char *filename, uint64_t *size, int64_t *mtime);
+bool file_id(const char *filename, FileId *id);
+bool file_id_open(FILE *file, FileId *id);
+bool file_id_equal(const FileId *a, const FileId *b);
+
+#endif
@@ -0,0 +1,278 @@
+// reading_model.c - Virtual Reading Table Model Module
+
+#include "reading_model.h"
+#include "arena.h"
+#include "store.h"
+#include "timestamp.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct _ReadingModel {
+    GObject parent;
+    const ReadingStore *store;
+    const char *const *temp_status_text;
+    const char *const *humid_status_text;
+    guint8 *levels;       // Temperature level in the low nibble, humidity in the high one
+    size_t rows;          // Readings shown so far
+    size_t capacity;
+    gint stamp;           // Changes on reset, so stale iterators are detected
+    GtkTreePath *append_path;  // Path of the next row, moved along instead of built for every row
+};
+
+static void reading_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(ReadingModel, reading_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, reading_model_tree_model_init))
+
+// Row index travels in the iterator itself, no per-row node is allocated
+static inline size_t iter_row(const GtkTreeIter *iter) {
+    return GPOINTER_TO_SIZE(iter->user_data);
+}
+
+static inline void set_iter(ReadingModel *m, size_t row, GtkTreeIter *iter) {
+    iter->stamp = m->stamp;
+    iter->user_data = GSIZE_TO_POINTER(row);
+    iter->user_data2 = NULL;
+    iter->user_data3 = NULL;
+}
+
+static GtkTreeModelFlags rm_get_flags(GtkTreeModel *model) {
+    return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+static gint rm_get_n_columns(GtkTreeModel *model) {
+    return READING_N_COLUMNS;
+}
+
+static GType rm_get_column_type(GtkTreeModel *model, gint column) {
+    switch (column) {
+        case READING_COL_SEQ:
+        case READING_COL_TEMP_LEVEL:
+        case READING_COL_HUMID_LEVEL:
+        case READING_COL_SENSOR:
+            return G_TYPE_INT;
+        case READING_COL_TIMESTAMP:
+        case READING_COL_TEMPERATURE:
+        case READING_COL_HUMIDITY:
+        case READING_COL_TEMP_STATUS:
+        case READING_COL_HUMID_STATUS:
+            return G_TYPE_STRING;
+        default:
+            return G_TYPE_INVALID;
+    }
+}
+
+static gboolean rm_get_iter(GtkTreeModel *model, GtkTreeIter *iter, GtkTreePath *path) {
+    ReadingModel *m = READING_MODEL(model);
+    if (gtk_tree_path_get_depth(path) != 1) return FALSE;
+
+    gint row = gtk_tree_path_get_indices(path)[0];
+    if (row < 0 || (size_t)row >= m->rows) return FALSE;
+    set_iter(m, (size_t)row, iter);
+    return TRUE;
+}
+
+static GtkTreePath *rm_get_path(GtkTreeModel *model, GtkTreeIter *iter) {
+    g_return_val_if_fail(iter->stamp == READING_MODEL(model)->stamp, NULL);
+    return gtk_tree_path_new_from_indices((gint)iter_row(iter), -1);
+}
+
+// Value with two decimals and a unit, written by format_fixed() instead of snprintf.
+// The GValue gets its own copy: a caller may keep it as long as it likes.
+static void set_fixed(GValue *value, double number, const char *suffix) {
+    char text[FORMAT_FIXED_LEN + 8];
+    size_t len = format_fixed(number, 2, text, FORMAT_FIXED_LEN);
+    size_t suffix_len = strlen(suffix);
+    if (len < FORMAT_FIXED_LEN && suffix_len < sizeof(text) - len) {
+        memcpy(text + len, suffix, suffix_len + 1);
+        g_value_set_string(value, text);
+    } else {
+        g_value_take_string(value, g_strdup_printf("%.2f%s", number, suffix));  // Did not fit, rare
+    }
+}
+
+// Formats one cell on demand, called only for rows GTK is about to draw or measure
+static void rm_get_value(GtkTreeModel *model, GtkTreeIter *iter, gint column, GValue *value) {
+    ReadingModel *m = READING_MODEL(model);
+    size_t row = iter_row(iter);
+    g_return_if_fail(iter->stamp == m->stamp && row < m->rows);
+
+    g_value_init(value, rm_get_column_type(model, column));
+    switch (column) {
+        case READING_COL_SEQ:
+            g_value_set_int(value, store_seq_no(m->store, row));
+            break;
+        case READING_COL_TIMESTAMP: {
+            char ts[TIMESTAMP_LEN];
+            timestamp_format(store_epoch(m->store, row), ts);
+            g_value_set_string(value, ts);
+            break;
+        }
+        case READING_COL_TEMPERATURE:
+            set_fixed(value, store_temperature(m->store, row), " °C");
+            break;
+        case READING_COL_HUMIDITY:
+            set_fixed(value, store_humidity(m->store, row), " %");
+            break;
+        case READING_COL_TEMP_STATUS:  // Status texts are constants that outlive any GValue
+            g_value_set_static_string(value, m->temp_status_text[m->levels[row] & 0x0F]);
+            break;
+        case READING_COL_HUMID_STATUS:
+            g_value_set_static_string(value, m->humid_status_text[m->levels[row] >> 4]);
+            break;
+        case READING_COL_TEMP_LEVEL:
+            g_value_set_int(value, m->levels[row] & 0x0F);
+            break;
+        case READING_COL_HUMID_LEVEL:
+            g_value_set_int(value, m->levels[row] >> 4);
+            break;
+        case READING_COL_SENSOR:
+            g_value_set_int(value, store_sensor_id(m->store, row));
+            break;
+    }
+}
+
+static gboolean rm_iter_next(GtkTreeModel *model, GtkTreeIter *iter) {
+    ReadingModel *m = READING_MODEL(model);
+    size_t row = iter_row(iter) + 1;
+    if (row >= m->rows) return FALSE;
+    set_iter(m, row, iter);
+    return TRUE;
+}
+
+static gboolean rm_iter_previous(GtkTreeModel *model, GtkTreeIter *iter) {
+    ReadingModel *m = READING_MODEL(model);
+    size_t row = iter_row(iter);
+    if (row == 0) return FALSE;
+    set_iter(m, row - 1, iter);
+    return TRUE;
+}
+
+static gboolean rm_iter_nth_child(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent, gint n) {
+    ReadingModel *m = READING_MODEL(model);
+    if (parent || n < 0 || (size_t)n >= m->rows) return FALSE;
+    set_iter(m, (size_t)n, iter);
+    return TRUE;
+}
+
+static gboolean rm_iter_children(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent) {
+    return rm_iter_nth_child(model, iter, parent, 0);
+}
+
+static gboolean rm_iter_has_child(GtkTreeModel *model, GtkTreeIter *iter) {
+    return FALSE;
+}
+
+static gint rm_iter_n_children(GtkTreeModel *model, GtkTreeIter *iter) {
+    return iter ? 0 : (gint)READING_MODEL(model)->rows;
+}
+
+static gboolean rm_iter_parent(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *child) {
+    return FALSE;
+}
+
+static void reading_model_tree_model_init(GtkTreeModelIface *iface) {
+    iface->get_flags = rm_get_flags;
+    iface->get_n_columns = rm_get_n_columns;
+    iface->get_column_type = rm_get_column_type;
+    iface->get_iter = rm_get_iter;
+    iface->get_path = rm_get_path;
+    iface->get_value = rm_get_value;
+    iface->iter_next = rm_iter_next;
+    iface->iter_previous = rm_iter_previous;
+    iface->iter_children = rm_iter_children;
+    iface->iter_has_child = rm_iter_has_child;
+    iface->iter_n_children = rm_iter_n_children;
+    iface->iter_nth_child = rm_iter_nth_child;
+    iface->iter_parent = rm_iter_parent;
+}
+
+static void reading_model_finalize(GObject *object) {
+    ReadingModel *m = READING_MODEL(object);
+    free(m->levels);
+    gtk_tree_path_free(m->append_path);
+    G_OBJECT_CLASS(reading_model_parent_class)->finalize(object);
+}
+
+static void reading_model_class_init(ReadingModelClass *klass) {
+    G_OBJECT_CLASS(klass)->finalize = reading_model_finalize;
+}
+
+static void reading_model_init(ReadingModel *m) {
+    m->stamp = g_random_int();
+    m->append_path = gtk_tree_path_new_first();
+}
+
+// Creates an empty model over a store, the store and status tables must outlive it
+ReadingModel *reading_model_new(const ReadingStore *store,
+                                const char *const *temp_status_text, const char *const *humid_status_text) {
+    ReadingModel *m = g_object_new(READING_TYPE_MODEL, NULL);
+    m->store = store;
+    m->temp_status_text = temp_status_text;
+    m->humid_status_text = humid_status_text;
+    return m;
+}
+
+// Removes every row. A view is notified row by row, so detach big tables from
+// their view first (gtk_tree_view_set_model(view, NULL)).
+void reading_model_reset(ReadingModel *m) {
+    while (m->rows > 0) {
+        m->rows--;
+        gtk_tree_path_prev(m->append_path);
+        gtk_tree_model_row_deleted(GTK_TREE_MODEL(m), m->append_path);
+    }
+    m->stamp++;
+}
+
+// Shows the next reading of the store with its alert levels
+gboolean reading_model_append(ReadingModel *m, AlertLevel temp_level, AlertLevel humid_level) {
+    if (m->rows >= m->store->count) return FALSE;
+    if (m->rows == m->capacity) {
+        size_t capacity = m->capacity ? m->capacity * 2 : 1024;
+        guint8 *levels = realloc(m->levels, capacity);
+        if (!levels) return FALSE;
+        m->levels = levels;
+        m->capacity = capacity;
+    }
+
+    size_t row = m->rows++;
+    m->levels[row] = (guint8)(temp_level | (humid_level << 4));
+
+    GtkTreeIter iter;
+    set_iter(m, row, &iter);
+    gtk_tree_model_row_inserted(GTK_TREE_MODEL(m), m->append_path, &iter);
+    gtk_tree_path_next(m->append_path);
+    return TRUE;
+}
+
+size_t reading_model_rows(ReadingModel *m) {
+    return m->rows;
+}
+
+gboolean reading_model_iter(ReadingModel *m, size_t row, GtkTreeIter *iter) {
+    if (row >= m->rows) return FALSE;
+    set_iter(m, row, iter);
+    return TRUE;
+}
+
+// Row of an iterator, lets cell data functions skip building a GtkTreePath
+size_t reading_model_iter_row(const GtkTreeIter *iter) {
+    return iter_row(iter);
+}
+
+// Asks the view to redraw a single row
+void reading_model_row_changed(ReadingModel *m, size_t row) {
+    GtkTreeIter iter;
+    if (!reading_model_iter(m, row, &iter)) return;
+    GtkTreePath *path = gtk_tree_path_new_from_indices((gint)row, -1);
+    gtk_tree_model_row_changed(GTK_TREE_MODEL(m), path, &iter);
+    gtk_tree_path_free(path);
+}
+
+AlertLevel reading_model_temp_level(ReadingModel *m, size_t row) {
+    return (AlertLevel)(m->levels[row] & 0x0F);
+}
+
+AlertLevel reading_model_humid_level(ReadingModel *m, size_t row) {
+    return (AlertLevel)(m->levels[row] >> 4);
+}
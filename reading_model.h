@@ -0,0 +1,42 @@
+// reading_model.h - Declaration of reading_model.c functions and structures
+
+#ifndef READING_MODEL_H
+#define READING_MODEL_H
+
+#include <gtk/gtk.h>
+#include <stddef.h>
+#include "simulator.h"
+#include "stats.h"
+
+// Columns of the reading table, cells are formatted only when GTK asks for them.
+enum {
+    READING_COL_SEQ,             // G_TYPE_INT
+    READING_COL_TIMESTAMP,       // G_TYPE_STRING
+    READING_COL_TEMPERATURE,     // G_TYPE_STRING, "%.2f °C"
+    READING_COL_HUMIDITY,        // G_TYPE_STRING, "%.2f %"
+    READING_COL_TEMP_STATUS,     // G_TYPE_STRING, from the status text table
+    READING_COL_HUMID_STATUS,    // G_TYPE_STRING
+    READING_COL_TEMP_LEVEL,      // G_TYPE_INT, AlertLevel
+    READING_COL_HUMID_LEVEL,     // G_TYPE_INT, AlertLevel
+    READING_COL_SENSOR,          // G_TYPE_INT
+    READING_N_COLUMNS
+};
+
+// Declaration of list model over the first `rows` readings of a ReadingStore.
+// The only per-row state is one byte holding both alert levels.
+#define READING_TYPE_MODEL (reading_model_get_type())
+G_DECLARE_FINAL_TYPE(ReadingModel, reading_model, READING, MODEL, GObject)
+
+// Declaration of required functions
+ReadingModel *reading_model_new(const ReadingStore *store,
+                                const char *const *temp_status_text, const char *const *humid_status_text);
+void reading_model_reset(ReadingModel *model);
+gboolean reading_model_append(ReadingModel *model, AlertLevel temp_level, AlertLevel humid_level);
+size_t reading_model_rows(ReadingModel *model);
+gboolean reading_model_iter(ReadingModel *model, size_t row, GtkTreeIter *iter);
+size_t reading_model_iter_row(const GtkTreeIter *iter);
+void reading_model_row_changed(ReadingModel *model, size_t row);
+AlertLevel reading_model_temp_level(ReadingModel *model, size_t row);
+AlertLevel reading_model_humid_level(ReadingModel *model, size_t row);
+
+#endif
@@ -0,0 +1,89 @@
+// ringbuf.c - Lock-Free Reading Queue Module
+
+#include "ringbuf.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Allocates room for at least capacity samples, rounded up to a power of two
+bool ring_init(RingBuffer *r, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+
+    memset(r, 0, sizeof(*r));
+    r->slots = malloc(size * sizeof(RingSample));
+    if (!r->slots) return false;
+    r->mask = size - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return true;
+}
+
+void ring_free(RingBuffer *r) {
+    free(r->slots);
+    memset(r, 0, sizeof(*r));
+}
+
+// Empties the queue, only while neither the producer nor the consumer is running
+void ring_clear(RingBuffer *r) {
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+    r->cached_head = 0;
+    r->cached_tail = 0;
+}
+
+// Copies count samples starting at position pos, wrapping around the end of the slots
+static void copy_in(RingBuffer *r, size_t pos, const RingSample *src, size_t count) {
+    size_t slot = pos & r->mask;
+    size_t first = ring_capacity(r) - slot;
+    if (first > count) first = count;
+    memcpy(&r->slots[slot], src, first * sizeof(RingSample));
+    memcpy(&r->slots[0], src + first, (count - first) * sizeof(RingSample));
+}
+
+static void copy_out(RingBuffer *r, size_t pos, RingSample *dst, size_t count) {
+    size_t slot = pos & r->mask;
+    size_t first = ring_capacity(r) - slot;
+    if (first > count) first = count;
+    memcpy(dst, &r->slots[slot], first * sizeof(RingSample));
+    memcpy(dst + first, &r->slots[0], (count - first) * sizeof(RingSample));
+}
+
+// Producer side: queues as many of the n samples as fit, returns how many did
+size_t ring_push(RingBuffer *r, const RingSample *samples, size_t n) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t room = ring_capacity(r) - (head - r->cached_tail);
+    if (room < n) {
+        // Only look at the consumer's index when the cached one says we are short
+        r->cached_tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        room = ring_capacity(r) - (head - r->cached_tail);
+    }
+    if (n > room) n = room;
+    if (n == 0) return 0;
+
+    copy_in(r, head, samples, n);
+    atomic_store_explicit(&r->head, head + n, memory_order_release);  // Publishes the copied slots
+    return n;
+}
+
+// Consumer side: takes up to max samples in arrival order, returns how many
+size_t ring_pop(RingBuffer *r, RingSample *out, size_t max) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t avail = r->cached_head - tail;
+    if (avail < max) {
+        r->cached_head = atomic_load_explicit(&r->head, memory_order_acquire);
+        avail = r->cached_head - tail;
+    }
+    if (max > avail) max = avail;
+    if (max == 0) return 0;
+
+    copy_out(r, tail, out, max);
+    atomic_store_explicit(&r->tail, tail + max, memory_order_release);  // Hands the slots back
+    return max;
+}
+
+// Samples queued right now, exact only when called by the producer or the consumer
+size_t ring_count(RingBuffer *r) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    return head - tail;
+}
@@ -0,0 +1,46 @@
+// ringbuf.h - Declaration of ringbuf.c functions and structures
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Declaration of one reading in flight between the acquisition thread and the GUI
+typedef struct {
+    int64_t epoch;
+    double temperature;
+    double humidity;
+    int32_t seq_no;
+    int32_t sensor_id;
+} RingSample;
+
+// Declaration of bounded single-producer/single-consumer queue. Exactly one thread
+// may push and exactly one other thread may pop, no locks are taken by either.
+// head and tail only ever grow, the slot is picked by masking.
+typedef struct {
+    RingSample *slots;
+    size_t mask;                           // Capacity - 1, capacity is a power of two
+
+    _Alignas(64) atomic_size_t head;       // Next slot to write, advanced by the producer
+    size_t cached_tail;                    // Producer's last view of tail
+
+    _Alignas(64) atomic_size_t tail;       // Next slot to read, advanced by the consumer
+    size_t cached_head;                    // Consumer's last view of head
+} RingBuffer;
+
+// Declaration of required functions
+bool ring_init(RingBuffer *r, size_t capacity);
+void ring_free(RingBuffer *r);
+void ring_clear(RingBuffer *r);
+size_t ring_push(RingBuffer *r, const RingSample *samples, size_t n);
+size_t ring_pop(RingBuffer *r, RingSample *out, size_t max);
+size_t ring_count(RingBuffer *r);
+
+static inline size_t ring_capacity(const RingBuffer *r) {
+    return r->mask + 1;
+}
+
+#endif
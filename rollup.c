@@ -0,0 +1,269 @@
+// rollup.c - Multi-Resolution Rollup Module
+
+#include "rollup.h"
+#include "platform.h"
+#include "store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(RollupBucket) == 64, "bucket layout changed");
+
+// Range ends are clamped so bucket arithmetic cannot overflow
+#define EPOCH_LIMIT (INT64_MAX / 4)
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && a < 0) ? q - 1 : q;
+}
+
+static int64_t clamp_epoch(int64_t e) {
+    return e < -EPOCH_LIMIT ? -EPOCH_LIMIT : (e > EPOCH_LIMIT ? EPOCH_LIMIT : e);
+}
+
+void rollup_init(Rollup *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+void rollup_free(Rollup *r) {
+    for (int l = 0; l < ROLLUP_LEVELS; l++) free(r->level[l].buckets);
+    rollup_init(r);
+}
+
+// Drops every bucket but keeps the allocations
+void rollup_reset(Rollup *r) {
+    for (int l = 0; l < ROLLUP_LEVELS; l++) r->level[l].count = 0;
+    r->source_count = 0;
+}
+
+static void channel_add(RollupChannel *c, double v, bool first) {
+    if (first) {
+        c->min = c->max = c->sum = v;
+        return;
+    }
+    if (v < c->min) c->min = v;
+    if (v > c->max) c->max = v;
+    c->sum += v;
+}
+
+static void channel_merge(RollupChannel *a, const RollupChannel *b) {
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+    a->sum += b->sum;
+}
+
+static void bucket_merge(RollupBucket *a, const RollupBucket *b) {
+    if (b->count == 0) return;
+    if (a->count == 0) {
+        int64_t start = a->start;
+        *a = *b;
+        a->start = start;
+        return;
+    }
+    channel_merge(&a->temp, &b->temp);
+    channel_merge(&a->humid, &b->humid);
+    a->count += b->count;
+}
+
+// Index of the first bucket with start >= value
+static size_t lower_bound(const RollupSeries *s, int64_t value) {
+    size_t lo = 0, hi = s->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (s->buckets[mid].start < value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Bucket starting at `start`, inserted in time order when missing
+static RollupBucket *find_or_insert(RollupSeries *s, int64_t start) {
+    // Readings nearly always arrive in order, so the last bucket is checked first
+    size_t pos = s->count;
+    if (s->count && s->buckets[s->count - 1].start == start) return &s->buckets[s->count - 1];
+    if (s->count && s->buckets[s->count - 1].start > start) {
+        pos = lower_bound(s, start);
+        if (s->buckets[pos].start == start) return &s->buckets[pos];
+    }
+
+    if (s->count == s->capacity) {
+        size_t capacity = s->capacity ? s->capacity * 2 : 64;
+        RollupBucket *buckets = realloc(s->buckets, capacity * sizeof(RollupBucket));
+        if (!buckets) return NULL;
+        s->buckets = buckets;
+        s->capacity = capacity;
+    }
+    memmove(&s->buckets[pos + 1], &s->buckets[pos], (s->count - pos) * sizeof(RollupBucket));
+    s->count++;
+
+    RollupBucket *b = &s->buckets[pos];
+    memset(b, 0, sizeof(*b));
+    b->start = start;
+    return b;
+}
+
+// Adds one reading to the bucket of every level, O(1) for readings in time order
+bool rollup_add(Rollup *r, int64_t epoch, double temperature, double humidity) {
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        int64_t width = rollup_seconds((RollupLevel)l);
+        RollupBucket *b = find_or_insert(&r->level[l], floor_div(epoch, width) * width);
+        if (!b) return false;
+
+        channel_add(&b->temp, temperature, b->count == 0);
+        channel_add(&b->humid, humidity, b->count == 0);
+        b->count++;
+    }
+    r->source_count++;
+    return true;
+}
+
+// Adds readings [first, store->count) of a store
+bool rollup_add_store(Rollup *r, const ReadingStore *store, size_t first) {
+    for (size_t i = first; i < store->count; i++) {
+        if (!rollup_add(r, store_epoch(store, i), store_temperature(store, i), store_humidity(store, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Buckets of one level overlapping [from, to], returned as a slice of the series
+const RollupBucket *rollup_range(const Rollup *r, RollupLevel level, int64_t from, int64_t to, size_t *n) {
+    const RollupSeries *s = &r->level[level];
+    from = clamp_epoch(from);
+    to = clamp_epoch(to);
+
+    size_t first = lower_bound(s, floor_div(from, rollup_seconds(level)) * rollup_seconds(level));
+    size_t end = to >= from ? lower_bound(s, to + 1) : first;
+    *n = end > first ? end - first : 0;
+    return s->buckets + first;
+}
+
+// Finest level that covers [from, to] with at most max_buckets buckets
+RollupLevel rollup_pick_level(int64_t from, int64_t to, size_t max_buckets) {
+    for (int l = 0; l < ROLLUP_LEVELS - 1; l++) {
+        int64_t width = rollup_seconds((RollupLevel)l);
+        if ((uint64_t)(to - from) / (uint64_t)width + 1 <= max_buckets) return (RollupLevel)l;
+    }
+    return ROLLUP_LEVELS - 1;
+}
+
+// Merges the buckets of a level whose start lies in [lo, hi]
+static void merge_starts(const RollupSeries *s, int64_t lo, int64_t hi, RollupBucket *out) {
+    for (size_t i = lower_bound(s, lo); i < s->count && s->buckets[i].start <= hi; i++) {
+        bucket_merge(out, &s->buckets[i]);
+    }
+}
+
+// Whole buckets of this level cover the middle of the range, finer levels the ends
+static void summarize(const Rollup *r, int level, int64_t from, int64_t to, RollupBucket *out) {
+    if (from > to) return;
+    if (level == ROLLUP_MINUTE) {
+        merge_starts(&r->level[level], from, to, out);
+        return;
+    }
+
+    int64_t width = rollup_seconds((RollupLevel)level);
+    int64_t full_from = -floor_div(-from, width) * width;    // First bucket starting at or after from
+    int64_t full_end = floor_div(to + 1, width) * width;     // End of the last bucket ending by to
+    if (full_from >= full_end) {
+        summarize(r, level - 1, from, to, out);
+        return;
+    }
+
+    summarize(r, level - 1, from, full_from - 1, out);
+    merge_starts(&r->level[level], full_from, full_end - 1, out);
+    summarize(r, level - 1, full_end, to, out);
+}
+
+// Aggregate of [from, to] at minute resolution: a minute counts when it starts inside
+// the range. Reads whole days, then hours, then minutes only at the two ends.
+void rollup_summary(const Rollup *r, int64_t from, int64_t to, RollupBucket *out) {
+    memset(out, 0, sizeof(*out));
+    from = clamp_epoch(from);
+    to = clamp_epoch(to);
+    out->start = from;
+    summarize(r, ROLLUP_LEVELS - 1, from, to, out);
+}
+
+// Saves a pyramid built from all of data_filename, stamped with that file's size and time
+bool rollup_save(const Rollup *r, const char *filename, const char *data_filename) {
+    RollupFileHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!file_stamp(data_filename, &header.source_size, &header.source_mtime)) return false;
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) return false;
+
+    memcpy(header.magic, ROLLUP_MAGIC, 4);
+    header.version = ROLLUP_VERSION;
+    header.levels = ROLLUP_LEVELS;
+    header.source_count = r->source_count;
+    for (int l = 0; l < ROLLUP_LEVELS; l++) header.bucket_count[l] = r->level[l].count;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int l = 0; l < ROLLUP_LEVELS && ok; l++) {
+        ok = fwrite(r->level[l].buckets, sizeof(RollupBucket), r->level[l].count, file) == r->level[l].count;
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) remove(filename);
+    return ok;
+}
+
+// True when a saved pyramid was built from data_filename as it is now (same size and time)
+bool rollup_matches(const char *filename, const char *data_filename) {
+    uint64_t size;
+    int64_t mtime;
+    if (!file_stamp(data_filename, &size, &mtime)) return false;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) return false;
+    RollupFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, ROLLUP_MAGIC, 4) == 0 && header.version == ROLLUP_VERSION &&
+              header.source_size == size && header.source_mtime == mtime;
+    fclose(file);
+    return ok;
+}
+
+// Replaces the contents of r with a saved pyramid
+bool rollup_load(Rollup *r, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return false;
+
+    RollupFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, ROLLUP_MAGIC, 4) == 0 &&
+              header.version == ROLLUP_VERSION && header.levels == ROLLUP_LEVELS;
+
+    rollup_reset(r);
+    for (int l = 0; l < ROLLUP_LEVELS && ok; l++) {
+        RollupSeries *s = &r->level[l];
+        size_t n = (size_t)header.bucket_count[l];
+        if (n > s->capacity) {
+            RollupBucket *buckets = realloc(s->buckets, n * sizeof(RollupBucket));
+            if (!buckets) {
+                ok = false;
+                break;
+            }
+            s->buckets = buckets;
+            s->capacity = n;
+        }
+        ok = fread(s->buckets, sizeof(RollupBucket), n, file) == n;
+        s->count = n;
+    }
+    fclose(file);
+
+    if (!ok) {
+        rollup_reset(r);
+        return false;
+    }
+    r->source_count = header.source_count;
+    return true;
+}
+
+// Name of the rollup file kept next to a data file
+void rollup_path(const char *data_filename, char *out, size_t size) {
+    snprintf(out, size, "%s%s", data_filename, ROLLUP_SUFFIX);
+}
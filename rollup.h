@@ -0,0 +1,85 @@
+// rollup.h - Declaration of rollup.c functions and structures
+
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+
+// Rollup file layout (little-endian, native struct layout):
+//   RollupFileHeader | RollupBucket x bucket_count[0] | ... x bucket_count[ROLLUP_LEVELS - 1]
+// Saved next to the data file as "<data file>.rollup"
+
+#define ROLLUP_MAGIC "THLR"
+#define ROLLUP_VERSION 2
+#define ROLLUP_SUFFIX ".rollup"
+
+// Declaration of pyramid levels, finest first
+typedef enum {
+    ROLLUP_MINUTE,
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_LEVELS
+} RollupLevel;
+
+typedef struct {
+    double min;
+    double max;
+    double sum;
+} RollupChannel;
+
+// Declaration of one aggregate bucket, covering [start, start + level width)
+typedef struct {
+    int64_t start;
+    uint64_t count;
+    RollupChannel temp;
+    RollupChannel humid;
+} RollupBucket;
+
+// Declaration of one level, buckets kept in time order
+typedef struct {
+    RollupBucket *buckets;
+    size_t count;
+    size_t capacity;
+} RollupSeries;
+
+typedef struct {
+    RollupSeries level[ROLLUP_LEVELS];
+    uint64_t source_count;   // Readings added, lets a saved pyramid be checked against its data
+} Rollup;
+
+typedef struct {
+    char magic[4];           // ROLLUP_MAGIC
+    uint16_t version;        // ROLLUP_VERSION
+    uint16_t levels;         // ROLLUP_LEVELS
+    uint64_t source_count;
+    uint64_t source_size;    // Size and modification time of the data file it was built from
+    int64_t source_mtime;
+    uint64_t bucket_count[ROLLUP_LEVELS];
+} RollupFileHeader;
+
+// Bucket width of a level in seconds
+static inline int64_t rollup_seconds(RollupLevel level) {
+    static const int64_t seconds[ROLLUP_LEVELS] = { 60, 3600, 86400 };
+    return seconds[level];
+}
+
+// Declaration of required functions
+void rollup_init(Rollup *r);
+void rollup_free(Rollup *r);
+void rollup_reset(Rollup *r);
+bool rollup_add(Rollup *r, int64_t epoch, double temperature, double humidity);
+bool rollup_add_store(Rollup *r, const ReadingStore *store, size_t first);
+
+const RollupBucket *rollup_range(const Rollup *r, RollupLevel level, int64_t from, int64_t to, size_t *n);
+RollupLevel rollup_pick_level(int64_t from, int64_t to, size_t max_buckets);
+void rollup_summary(const Rollup *r, int64_t from, int64_t to, RollupBucket *out);
+
+bool rollup_save(const Rollup *r, const char *filename, const char *data_filename);
+bool rollup_matches(const char *filename, const char *data_filename);
+bool rollup_load(Rollup *r, const char *filename);
+void rollup_path(const char *data_filename, char *out, size_t size);
+
+#endif
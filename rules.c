@@ -0,0 +1,375 @@
+// rules.c - Alert Rule Engine Module
+
+#include "rules.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void rules_init(RuleEngine *e) {
+    memset(e, 0, sizeof(*e));
+}
+
+static void free_sensors(RuleEngine *e) {
+    for (size_t i = 0; i < e->sensor_count; i++) free(e->sensors[i].counters);
+    e->sensor_count = 0;
+    e->last = 0;
+}
+
+void rules_free(RuleEngine *e) {
+    free_sensors(e);
+    free(e->sensors);
+    free(e->slots);
+    free(e->rules);
+    free(e->code);
+    free(e->programs);
+    rules_init(e);
+}
+
+// Forgets every rule, rules_compile() must run before the next evaluation
+void rules_clear(RuleEngine *e) {
+    e->count = 0;
+}
+
+bool rules_add(RuleEngine *e, const Rule *rule) {
+    if (e->count == e->capacity) {
+        size_t capacity = e->capacity ? e->capacity * 2 : 16;
+        Rule *rules = realloc(e->rules, capacity * sizeof(Rule));
+        if (!rules) return false;
+        e->rules = rules;
+        e->capacity = capacity;
+    }
+    e->rules[e->count++] = *rule;
+    return true;
+}
+
+// Built-in rules: warning from RULE_DEFAULT_WARNING, alert above RULE_DEFAULT_ALERT, both channels
+bool rules_defaults(RuleEngine *e) {
+    rules_clear(e);
+    for (int channel = 0; channel < RULE_CHANNELS; channel++) {
+        Rule warning = { RULE_ANY_SENSOR, (RuleChannel)channel, RULE_VALUE, RULE_GE, RULE_DEFAULT_WARNING,
+                         LEVEL_WARNING, 1, 0.0 };
+        Rule alert = { RULE_ANY_SENSOR, (RuleChannel)channel, RULE_VALUE, RULE_GT, RULE_DEFAULT_ALERT,
+                       LEVEL_ALERT, 1, 0.0 };
+        if (!rules_add(e, &warning) || !rules_add(e, &alert)) return false;
+    }
+    return true;
+}
+
+// Copies the next blank-separated word of *p into out, returns false at the end of the line
+static bool next_word(const char **p, char *out, size_t size) {
+    const char *s = *p;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '\0' || *s == '#' || *s == '\n' || *s == '\r') return false;
+
+    size_t n = 0;
+    while (*s && !isspace((unsigned char)*s) && *s != '#') {
+        if (n + 1 < size) out[n++] = *s;
+        s++;
+    }
+    out[n] = '\0';
+    *p = s;
+    return true;
+}
+
+static bool parse_number(const char *word, double *value) {
+    char *end;
+    *value = strtod(word, &end);
+    return end != word && *end == '\0';
+}
+
+// Parses one line of a rules file. Blank and comment lines set *empty and succeed.
+bool rules_parse_line(const char *line, Rule *rule, bool *empty) {
+    char word[32];
+    double number;
+    const char *p = line;
+
+    *empty = !next_word(&p, word, sizeof(word));
+    if (*empty) return true;
+
+    memset(rule, 0, sizeof(*rule));
+    rule->sustain = 1;
+    if (strcmp(word, "temperature") == 0 || strcmp(word, "temp") == 0) rule->channel = RULE_TEMP;
+    else if (strcmp(word, "humidity") == 0 || strcmp(word, "humid") == 0) rule->channel = RULE_HUMID;
+    else return false;
+
+    if (!next_word(&p, word, sizeof(word))) return false;
+    if (strcmp(word, "*") == 0) {
+        rule->sensor = RULE_ANY_SENSOR;
+    } else {
+        if (!parse_number(word, &number) || number < 0 || number > 2147483647.0 || number != (int)number) return false;
+        rule->sensor = (int)number;
+    }
+
+    if (!next_word(&p, word, sizeof(word))) return false;
+    if (strcmp(word, "warning") == 0) rule->level = LEVEL_WARNING;
+    else if (strcmp(word, "alert") == 0) rule->level = LEVEL_ALERT;
+    else return false;
+
+    if (!next_word(&p, word, sizeof(word))) return false;
+    rule->kind = RULE_VALUE;
+    if (strcmp(word, "rate") == 0) {
+        rule->kind = RULE_RATE;
+        if (!next_word(&p, word, sizeof(word))) return false;
+    }
+    if (strcmp(word, ">") == 0) rule->op = RULE_GT;
+    else if (strcmp(word, ">=") == 0) rule->op = RULE_GE;
+    else if (strcmp(word, "<") == 0) rule->op = RULE_LT;
+    else if (strcmp(word, "<=") == 0) rule->op = RULE_LE;
+    else return false;
+
+    if (!next_word(&p, word, sizeof(word)) || !parse_number(word, &rule->limit)) return false;
+
+    while (next_word(&p, word, sizeof(word))) {
+        bool sustain = strcmp(word, "for") == 0;
+        if (!sustain && strcmp(word, "hysteresis") != 0) return false;
+        if (!next_word(&p, word, sizeof(word)) || !parse_number(word, &number) || number < 0) return false;
+        if (sustain) {
+            if (number < 1 || number > 1e9 || number != (uint32_t)number) return false;
+            rule->sustain = (uint32_t)number;
+        } else {
+            rule->hysteresis = number;
+        }
+    }
+    return true;
+}
+
+// Replaces the rules with those of a rules file. Returns false when the file cannot
+// be read (*error_line = 0) or a line is invalid (*error_line = its number); the
+// engine then has no rules.
+bool rules_load(RuleEngine *e, const char *filename, int *error_line) {
+    char line[RULES_MAX_LINE];
+    Rule rule;
+    bool empty;
+    int number = 0;
+
+    *error_line = 0;
+    rules_clear(e);
+    FILE *f = fopen(filename, "r");
+    if (!f) return false;
+
+    while (fgets(line, sizeof(line), f)) {
+        number++;
+        if (!rules_parse_line(line, &rule, &empty) || (!empty && !rules_add(e, &rule))) {
+            *error_line = number;
+            rules_clear(e);
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void compile_rule(const Rule *rule, CompiledRule *out) {
+    bool below = rule->op == RULE_LT || rule->op == RULE_LE;
+    out->input = (uint8_t)(rule->channel + RULE_CHANNELS * rule->kind);
+    out->strict = rule->op == RULE_GT || rule->op == RULE_LT;
+    out->level = (uint8_t)rule->level;
+    out->sign = below ? -1.0 : 1.0;
+    out->on = out->sign * rule->limit;
+    out->off = out->on - rule->hysteresis;
+    out->sustain = rule->sustain;
+}
+
+static int compare_rule_sensor(const void *a, const void *b) {
+    int x = ((const Rule *)a)->sensor, y = ((const Rule *)b)->sensor;
+    return (x > y) - (x < y);
+}
+
+// Builds the evaluation table: one program per sensor that has rules of its own
+// (its rules followed by the rules for every sensor), then the shared program.
+// Drops the state of the current run.
+bool rules_compile(RuleEngine *e) {
+    rules_reset(e);
+    qsort(e->rules, e->count, sizeof(Rule), compare_rule_sensor);  // RULE_ANY_SENSOR sorts first
+
+    size_t any = 0, programs = 0;
+    while (any < e->count && e->rules[any].sensor == RULE_ANY_SENSOR) any++;
+    for (size_t i = any; i < e->count; i++) {
+        if (i == any || e->rules[i].sensor != e->rules[i - 1].sensor) programs++;
+    }
+
+    size_t code_count = (e->count - any) + (programs + 1) * any;
+    CompiledRule *code = malloc((code_count ? code_count : 1) * sizeof(CompiledRule));
+    RuleProgram *list = malloc((programs ? programs : 1) * sizeof(RuleProgram));
+    if (!code || !list) {
+        free(code);
+        free(list);
+        return false;
+    }
+
+    size_t n = 0, p = 0;
+    for (size_t i = any; i < e->count; ) {
+        RuleProgram *program = &list[p++];
+        program->sensor = e->rules[i].sensor;
+        program->first = (uint32_t)n;
+        for (; i < e->count && e->rules[i].sensor == program->sensor; i++) compile_rule(&e->rules[i], &code[n++]);
+        for (size_t j = 0; j < any; j++) compile_rule(&e->rules[j], &code[n++]);
+        program->count = (uint32_t)(n - program->first);
+    }
+    e->any.sensor = RULE_ANY_SENSOR;
+    e->any.first = (uint32_t)n;
+    for (size_t j = 0; j < any; j++) compile_rule(&e->rules[j], &code[n++]);
+    e->any.count = (uint32_t)any;
+
+    free(e->code);
+    free(e->programs);
+    e->code = code;
+    e->code_count = n;
+    e->programs = list;
+    e->program_count = programs;
+    return true;
+}
+
+// Forgets every sensor's state for a new run, the compiled rules stay
+void rules_reset(RuleEngine *e) {
+    free_sensors(e);
+    if (e->slots) memset(e->slots, 0, e->slot_count * sizeof(int32_t));
+}
+
+static size_t hash_id(int id, size_t mask) {
+    return ((uint32_t)id * 2654435761u) & mask;  // Knuth multiplicative hash
+}
+
+// Slot holding id, or the empty slot where it would go
+static size_t probe(const RuleEngine *e, int id) {
+    size_t mask = e->slot_count - 1;
+    size_t i = hash_id(id, mask);
+    while (e->slots[i] && e->sensors[e->slots[i] - 1].id != id) i = (i + 1) & mask;
+    return i;
+}
+
+// Table kept at most half full, rebuilt from the sensor list when it grows
+static bool grow_slots(RuleEngine *e) {
+    size_t slot_count = e->slot_count ? e->slot_count * 2 : 64;
+    int32_t *slots = calloc(slot_count, sizeof(int32_t));
+    if (!slots) return false;
+
+    free(e->slots);
+    e->slots = slots;
+    e->slot_count = slot_count;
+    for (size_t s = 0; s < e->sensor_count; s++) {
+        e->slots[probe(e, e->sensors[s].id)] = (int32_t)(s + 1);
+    }
+    return true;
+}
+
+static const RuleProgram *find_program(const RuleEngine *e, int id) {
+    size_t lo = 0, hi = e->program_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (e->programs[mid].sensor < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < e->program_count && e->programs[lo].sensor == id ? &e->programs[lo] : &e->any;
+}
+
+// State of a sensor, created with its program on the first reading. NULL when out of memory.
+static RuleSensor *sensor_state(RuleEngine *e, int id) {
+    if (e->last && e->sensors[e->last - 1].id == id) return &e->sensors[e->last - 1];
+    if (e->slot_count > 0) {
+        size_t slot = probe(e, id);
+        if (e->slots[slot]) {
+            e->last = (size_t)e->slots[slot];
+            return &e->sensors[e->last - 1];
+        }
+    }
+
+    if ((e->sensor_count + 1) * 2 > e->slot_count && !grow_slots(e)) return NULL;
+    if (e->sensor_count == e->sensor_capacity) {
+        size_t capacity = e->sensor_capacity ? e->sensor_capacity * 2 : 16;
+        RuleSensor *sensors = realloc(e->sensors, capacity * sizeof(RuleSensor));
+        if (!sensors) return NULL;
+        e->sensors = sensors;
+        e->sensor_capacity = capacity;
+    }
+
+    const RuleProgram *program = find_program(e, id);
+    RuleSensor *s = &e->sensors[e->sensor_count];
+    memset(s, 0, sizeof(*s));
+    s->id = id;
+    s->first = program->first;
+    s->count = program->count;
+    s->counters = calloc(program->count ? program->count : 1, sizeof(RuleCounter));
+    if (!s->counters) return NULL;
+
+    e->slots[probe(e, id)] = (int32_t)(e->sensor_count + 1);
+    e->last = ++e->sensor_count;
+    return s;
+}
+
+// Runs the program of one sensor over one reading, returns the level per channel
+static void eval_reading(const CompiledRule *code, RuleSensor *s, int64_t epoch, double temperature,
+                         double humidity, AlertLevel *temp_level, AlertLevel *humid_level) {
+    double in[2 * RULE_CHANNELS] = { temperature, humidity, 0.0, 0.0 };
+    bool rate_known = s->has_previous && epoch > s->previous_epoch;
+    if (rate_known) {
+        double per_minute = 60.0 / (double)(epoch - s->previous_epoch);
+        in[RULE_CHANNELS + RULE_TEMP] = (temperature - s->previous[RULE_TEMP]) * per_minute;
+        in[RULE_CHANNELS + RULE_HUMID] = (humidity - s->previous[RULE_HUMID]) * per_minute;
+    }
+
+    uint8_t level[RULE_CHANNELS] = { LEVEL_SAFE, LEVEL_SAFE };
+    const CompiledRule *r = code + s->first;
+    for (uint32_t i = 0; i < s->count; i++, r++) {
+        RuleCounter *c = &s->counters[i];
+        if (r->input < RULE_CHANNELS || rate_known) {  // A rate needs two readings apart in time
+            double x = r->sign * in[r->input];
+            double limit = c->active ? r->off : r->on;
+            if (r->strict ? x > limit : x >= limit) {
+                if (c->run < r->sustain) c->run++;
+                if (c->run >= r->sustain) c->active = 1;
+            } else {
+                c->run = 0;
+                c->active = 0;
+            }
+        }
+        uint8_t *channel_level = &level[r->input % RULE_CHANNELS];
+        if (c->active && r->level > *channel_level) *channel_level = r->level;
+    }
+
+    s->has_previous = true;
+    s->previous_epoch = epoch;
+    s->previous[RULE_TEMP] = temperature;
+    s->previous[RULE_HUMID] = humidity;
+    *temp_level = (AlertLevel)level[RULE_TEMP];
+    *humid_level = (AlertLevel)level[RULE_HUMID];
+}
+
+// Levels of a block of readings, in arrival order. Each sensor keeps its own
+// sustain counters, hysteresis state and previous reading across calls.
+// Returns false if a sensor's state could not be allocated, its readings are safe.
+bool rules_eval(RuleEngine *e, const int *sensor_ids, const int64_t *epochs, const double *temperature,
+                const double *humidity, AlertLevel *temp_levels, AlertLevel *humid_levels, size_t n) {
+    bool ok = true;
+    for (size_t i = 0; i < n; i++) {
+        RuleSensor *s = sensor_state(e, sensor_ids[i]);
+        if (!s) {
+            temp_levels[i] = humid_levels[i] = LEVEL_SAFE;
+            ok = false;
+            continue;
+        }
+        eval_reading(e->code, s, epochs[i], temperature[i], humidity[i], &temp_levels[i], &humid_levels[i]);
+    }
+    return ok;
+}
+
+// Lowest warning and alert limits of the "above" value rules that apply to every
+// sensor, used to draw threshold bands. Returns false if the channel has neither.
+bool rules_band(const RuleEngine *e, RuleChannel channel, double *warning, double *alert) {
+    bool found[2] = { false, false };
+    double limit[2] = { 0.0, 0.0 };
+    for (size_t i = 0; i < e->count; i++) {
+        const Rule *r = &e->rules[i];
+        if (r->sensor != RULE_ANY_SENSOR || r->channel != channel || r->kind != RULE_VALUE) continue;
+        if (r->op != RULE_GT && r->op != RULE_GE) continue;
+        int k = r->level == LEVEL_ALERT;
+        if (!found[k] || r->limit < limit[k]) limit[k] = r->limit;
+        found[k] = true;
+    }
+    if (!found[0] && !found[1]) return false;
+    *warning = found[0] ? limit[0] : limit[1];
+    *alert = found[1] ? limit[1] : limit[0];
+    return true;
+}
@@ -0,0 +1,127 @@
+// rules.h - Declaration of rules.c functions and structures
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "stats.h"
+
+// Rules file, one rule per line ('#' starts a comment):
+//   <channel> <sensor> <level> [rate] <op> <limit> [for <n>] [hysteresis <h>]
+//   channel: temperature | humidity       sensor: id or * for every sensor
+//   level:   warning | alert              op:     > >= < <=
+//   rate:    test the change per minute since the sensor's previous reading
+//   for:     the test must hold for n readings in a row before the rule fires
+//   hysteresis: a fired rule clears only once the value is h past the limit
+// Example: temperature 3 alert rate > 0.5 for 3 hysteresis 0.2
+
+#define RULES_FILE "rules.conf"
+#define RULE_DEFAULT_WARNING 60.0  // Built-in rules when there is no rules file
+#define RULE_DEFAULT_ALERT 65.0
+#define RULE_ANY_SENSOR -1
+#define RULES_MAX_LINE 256
+
+typedef enum {
+    RULE_TEMP,
+    RULE_HUMID,
+    RULE_CHANNELS
+} RuleChannel;
+
+typedef enum {
+    RULE_VALUE,             // The value itself
+    RULE_RATE               // Change per minute since the previous reading of the sensor
+} RuleKind;
+
+typedef enum {
+    RULE_GT,
+    RULE_GE,
+    RULE_LT,
+    RULE_LE
+} RuleOp;
+
+// Declaration of one rule as written in the rules file
+typedef struct {
+    int sensor;             // RULE_ANY_SENSOR for every sensor
+    RuleChannel channel;
+    RuleKind kind;
+    RuleOp op;
+    double limit;
+    AlertLevel level;
+    uint32_t sustain;       // Readings in a row the test must hold (1 = fire at once)
+    double hysteresis;      // Distance back past the limit before a fired rule clears
+} Rule;
+
+// Declaration of one compiled rule. Every test is turned into "x > on" or "x >= on"
+// (a "<" test negates x and the limit), so evaluating is a multiply and one compare.
+typedef struct {
+    uint8_t input;          // Index into the reading inputs: channel + 2 * kind
+    uint8_t strict;         // > rather than >=
+    uint8_t level;          // AlertLevel raised while the rule is active
+    double sign;            // 1, or -1 for < tests
+    double on;              // Signed limit that fires the rule
+    double off;             // Signed limit an active rule must stay past (on - hysteresis)
+    uint32_t sustain;
+} CompiledRule;
+
+// Declaration of the rules that apply to one sensor id: a span of the compiled table
+typedef struct {
+    int sensor;
+    uint32_t first;
+    uint32_t count;
+} RuleProgram;
+
+// Declaration of the per-rule state of one sensor
+typedef struct {
+    uint32_t run;           // Readings in a row that passed the test
+    uint32_t active;        // Rule fired and not cleared yet
+} RuleCounter;
+
+// Declaration of evaluation state of one sensor, created on its first reading
+typedef struct {
+    int id;
+    uint32_t first;         // Program span, copied from the RuleProgram
+    uint32_t count;
+    RuleCounter *counters;  // One per rule of the span
+    bool has_previous;
+    int64_t previous_epoch;
+    double previous[RULE_CHANNELS];
+} RuleSensor;
+
+// Declaration of rule engine: the rules as loaded, the compiled table built from them
+// and the state of each sensor seen in the current run
+typedef struct {
+    Rule *rules;
+    size_t count;
+    size_t capacity;
+
+    CompiledRule *code;     // Per-sensor programs, then the program of every other sensor
+    size_t code_count;
+    RuleProgram *programs;  // Sensors with rules of their own, ordered by id
+    size_t program_count;
+    RuleProgram any;        // Rules for sensors without a program of their own
+
+    RuleSensor *sensors;
+    size_t sensor_count;
+    size_t sensor_capacity;
+    int32_t *slots;         // Sensor index + 1, 0 = empty
+    size_t slot_count;      // Power of two
+    size_t last;            // Sensor index + 1 of the previous reading, batches are often one sensor
+} RuleEngine;
+
+// Declaration of required functions
+void rules_init(RuleEngine *e);
+void rules_free(RuleEngine *e);
+void rules_clear(RuleEngine *e);
+bool rules_add(RuleEngine *e, const Rule *rule);
+bool rules_defaults(RuleEngine *e);
+bool rules_parse_line(const char *line, Rule *rule, bool *empty);
+bool rules_load(RuleEngine *e, const char *filename, int *error_line);
+bool rules_compile(RuleEngine *e);
+void rules_reset(RuleEngine *e);
+bool rules_eval(RuleEngine *e, const int *sensor_ids, const int64_t *epochs, const double *temperature,
+                const double *humidity, AlertLevel *temp_levels, AlertLevel *humid_levels, size_t n);
+bool rules_band(const RuleEngine *e, RuleChannel channel, double *warning, double *alert);
+
+#endif
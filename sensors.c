@@ -0,0 +1,165 @@
+// sensors.c - Per-Sensor Shard Module
+
+#include "sensors.h"
+#include "store.h"
+#include <stdlib.h>
+#include <string.h>
+
+void sensors_init(SensorSet *set, size_t window_size) {
+    memset(set, 0, sizeof(*set));
+    set->window_size = window_size;
+}
+
+static void free_shards(SensorSet *set) {
+    for (size_t i = 0; i < set->count; i++) {
+        free(set->shards[i]->rows);
+        window_free(&set->shards[i]->status_window);
+        free(set->shards[i]);
+    }
+    set->count = 0;
+}
+
+void sensors_free(SensorSet *set) {
+    free_shards(set);
+    free(set->shards);
+    free(set->slots);
+    sensors_init(set, 0);
+}
+
+// Drops every shard for a new run, new shards use window_size samples for their status
+void sensors_clear(SensorSet *set, size_t window_size) {
+    free_shards(set);
+    if (set->slots) memset(set->slots, 0, set->slot_count * sizeof(int32_t));
+    set->window_size = window_size;
+}
+
+static size_t hash_id(int id, size_t mask) {
+    return ((uint32_t)id * 2654435761u) & mask;  // Knuth multiplicative hash
+}
+
+// Slot holding id, or the empty slot where it would go
+static size_t probe(const SensorSet *set, int id) {
+    size_t mask = set->slot_count - 1;
+    size_t i = hash_id(id, mask);
+    while (set->slots[i] && set->shards[set->slots[i] - 1]->id != id) i = (i + 1) & mask;
+    return i;
+}
+
+SensorShard *sensors_find(const SensorSet *set, int id) {
+    if (set->slot_count == 0) return NULL;
+    size_t i = probe(set, id);
+    return set->slots[i] ? set->shards[set->slots[i] - 1] : NULL;
+}
+
+// Table kept at most half full, rebuilt from the shard list when it grows
+static bool grow_slots(SensorSet *set) {
+    size_t slot_count = set->slot_count ? set->slot_count * 2 : 64;
+    int32_t *slots = calloc(slot_count, sizeof(int32_t));
+    if (!slots) return false;
+
+    free(set->slots);
+    set->slots = slots;
+    set->slot_count = slot_count;
+    for (size_t s = 0; s < set->count; s++) {
+        set->slots[probe(set, set->shards[s]->id)] = (int32_t)(s + 1);
+    }
+    return true;
+}
+
+// Shard of a sensor, created on its first reading. Returns NULL when out of memory
+// or when MAX_SENSORS sensors are already tracked.
+SensorShard *sensors_get(SensorSet *set, int id) {
+    SensorShard *shard = sensors_find(set, id);
+    if (shard) return shard;
+    if (set->count >= MAX_SENSORS) return NULL;
+
+    if ((set->count + 1) * 2 > set->slot_count && !grow_slots(set)) return NULL;
+    if (set->count == set->capacity) {
+        size_t capacity = set->capacity ? set->capacity * 2 : 16;
+        SensorShard **shards = realloc(set->shards, capacity * sizeof(SensorShard *));
+        if (!shards) return NULL;
+        set->shards = shards;
+        set->capacity = capacity;
+    }
+
+    shard = calloc(1, sizeof(SensorShard));
+    if (!shard) return NULL;
+    if (!window_init(&shard->status_window, set->window_size, 0)) {
+        free(shard);
+        return NULL;
+    }
+    shard->id = id;
+    shard->sorted = true;
+    running_stats_reset(&shard->stats);
+
+    set->shards[set->count] = shard;
+    set->slots[probe(set, id)] = (int32_t)(set->count + 1);
+    set->count++;
+    return shard;
+}
+
+// Records that store row `row` belongs to this shard
+bool sensors_add(SensorShard *shard, const ReadingStore *store, size_t row) {
+    if (shard->count == shard->capacity) {
+        size_t capacity = shard->capacity ? shard->capacity * 2 : 256;
+        size_t *rows = realloc(shard->rows, capacity * sizeof(size_t));
+        if (!rows) return false;
+        shard->rows = rows;
+        shard->capacity = capacity;
+    }
+    if (shard->count > 0 && store_epoch(store, row) < store_epoch(store, shard->rows[shard->count - 1])) {
+        shard->sorted = false;
+    }
+    shard->rows[shard->count++] = row;
+    return true;
+}
+
+// Values the rules judge for a reading: the moving average over the status window of
+// the reading's own sensor, so a single noisy sample cannot flip the status and sensors
+// never mix in one average. A NULL shard (untracked sensor) gets the reading itself.
+// The GUI and the CLI both go through here, so a log gets the same alerts in each.
+void sensors_status(SensorShard *shard, int64_t epoch, double temperature, double humidity,
+                    double *status_temp, double *status_humid) {
+    *status_temp = temperature;
+    *status_humid = humidity;
+    if (!shard) return;
+
+    WindowStats avg_temp, avg_humid;
+    window_push(&shard->status_window, epoch, temperature, humidity);
+    window_get(&shard->status_window, WINDOW_TEMP, &avg_temp);
+    window_get(&shard->status_window, WINDOW_HUMID, &avg_humid);
+    *status_temp = avg_temp.mean;
+    *status_humid = avg_humid.mean;
+}
+
+// First position in rows with epoch >= value, rows must be sorted
+static size_t lower_bound(const SensorShard *shard, const ReadingStore *store, int64_t value) {
+    size_t lo = 0, hi = shard->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store_epoch(store, shard->rows[mid]) < value) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Statistics of this sensor's readings with from <= epoch <= to (alert counters stay 0)
+void sensors_range_stats(const SensorShard *shard, const ReadingStore *store, int64_t from, int64_t to,
+                         Statistics *out) {
+    RunningStats rs;
+    running_stats_reset(&rs);
+
+    size_t first = shard->sorted ? lower_bound(shard, store, from) : 0;
+    for (size_t i = first; i < shard->count; i++) {
+        size_t row = shard->rows[i];
+        int64_t epoch = store_epoch(store, row);
+        if (epoch > to) {
+            if (shard->sorted) break;
+            continue;
+        }
+        if (epoch < from) continue;
+        running_stats_add(&rs, epoch, store_temperature(store, row), store_humidity(store, row),
+                          LEVEL_SAFE, LEVEL_SAFE);
+    }
+    running_stats_snapshot(&rs, out);
+}
@@ -0,0 +1,52 @@
+// sensors.h - Declaration of sensors.c functions and structures
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+#include "stats.h"
+#include "window.h"
+
+#define MAX_SENSORS 4096   // Most distinct sensor ids tracked in one run
+#define STATUS_WINDOW_SIZE 3  // Readings averaged per sensor before the rules assign a status
+
+// Declaration of per-sensor shard. Rows are indexes into the shared ReadingStore,
+// so a shard costs a few bytes per reading and nothing is copied. Shards are
+// separate allocations that never move: appends to different shards share no
+// memory, only creating a shard touches the set.
+typedef struct {
+    int id;
+    size_t *rows;             // Store indexes of this sensor's readings, in arrival order
+    size_t count;
+    size_t capacity;
+    bool sorted;              // Epochs of rows never decrease, enables binary search
+    RunningStats stats;       // Live aggregates of this sensor only
+    RollingWindow status_window;  // Moving average driving this sensor's status
+} SensorShard;
+
+// Declaration of sensor set, id -> shard through an open addressing table
+typedef struct {
+    SensorShard **shards;     // Creation order
+    size_t count;
+    size_t capacity;
+    int32_t *slots;           // Shard index + 1, 0 = empty
+    size_t slot_count;        // Power of two
+    size_t window_size;       // Status window of new shards
+} SensorSet;
+
+// Declaration of required functions
+void sensors_init(SensorSet *set, size_t window_size);
+void sensors_free(SensorSet *set);
+void sensors_clear(SensorSet *set, size_t window_size);
+SensorShard *sensors_get(SensorSet *set, int id);
+SensorShard *sensors_find(const SensorSet *set, int id);
+bool sensors_add(SensorShard *shard, const ReadingStore *store, size_t row);
+void sensors_status(SensorShard *shard, int64_t epoch, double temperature, double humidity,
+                    double *status_temp, double *status_humid);
+void sensors_range_stats(const SensorShard *shard, const ReadingStore *store, int64_t from, int64_t to,
+                         Statistics *out);
+
+#endif
@@ -1,69 +1,80 @@
 // simulator.c - Temperature and Humidity Data Simulation Module
 
 #include "simulator.h"
+#include "ingest.h"
+#include "platform.h"
+#include "store.h"
+#include "timestamp.h"
+#include "workload.h"
 #include <stdio.h>
-#include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
-#define GAP_MINUTES 28.8
-
 // Cross-platform function to start time with 0000hrs timestamp
 static time_t get_today_midnight() {
     time_t now = time(NULL);
     struct tm tm_info;
-    localtime_s(&tm_info, &now);
+    platform_localtime(now, &tm_info);
     tm_info.tm_hour = 0;
     tm_info.tm_min = 0;
     tm_info.tm_sec = 0;
     return mktime(&tm_info);  // Convert back to time_t
 }
 
-
 // Generates temperature and humidity readings for simulation 
 void generate_random_readings(Reading *readings, int n) {
-    time_t t = get_today_midnight(); // Start timestamps at 0000hrs
-    srand((unsigned)time(NULL));     // Seed random generator for different values each run
-    
-    for (int i = 0; i < n; i++) {
-        readings[i].seq_no = i + 1;  // Sequential numbering
-        
-        // Calculate timestamp - keeps 28.8 minutes gap
-        time_t ts = t + (int)(i * GAP_MINUTES * 60);
-        strftime(readings[i].timestamp, 32, "%Y-%m-%d %H:%M", localtime(&ts));
-        
-        // Generate temp humid values
-        readings[i].temperature = 50.0 + rand() % 30; // Temperature 50-79
-        readings[i].humidity = 50.0 + rand() % 30;    // Humidity 50-79%
+    ReadingStore store;
+    store_init(&store);
+    generate_random_store(&store, n > 0 ? (size_t)n : 0);
+
+    for (size_t i = 0; i < store.count; i++) {
+        store_get(&store, i, &readings[i]);
     }
+    store_free(&store);
 }
 
-bool read_csv_readings(const char *filename, Reading *readings, int n) {
-    FILE *f = fopen(filename, "r");
-    if (!f) return false;  // Return false if file cannot be opened
-    
-    char line[128];  // Buffer for reading each line
-    int i = 0;       // Counter for successfully read readings
-    
-    // Read file line by line until end
-    while (fgets(line, sizeof(line), f) && i < n) {
-        int seq;
-        char ts[32];
-        double temp, humid;
+// Same as generate_random_readings() but appends n readings to a store.
+// Uses the default workload with a clock seed, so every run differs.
+void generate_random_store(ReadingStore *store, size_t n) {
+    WorkloadConfig cfg;
+    Workload w;
 
-        // Parse seq_no,timestamp,temperature,humidity
-        if (sscanf(line, "%d,%31[^,],%lf,%lf", &seq, ts, &temp, &humid) == 4) {
-            //If all 4 fields are successfully parsed
-            readings[i].seq_no = seq;
-            strncpy(readings[i].timestamp, ts, 32);
-            readings[i].timestamp[31] = '\0';
-            readings[i].temperature = temp;
-            readings[i].humidity = humid;
-            i++;
-        }
-        // Skip lines that are incomplete
-    }
-    
-    fclose(f);
-    return (i == n);  // Return true only if we got exactly the expected number of readings
+    workload_defaults(&cfg);
+    cfg.seed = workload_clock_seed();
+    if (!workload_init(&w, &cfg)) return;
+    workload_generate(&w, store, n);  // Out of memory keeps what was generated
+    workload_free(&w);
+}
+
+// Epoch of the first simulated reading, today at 0000hrs
+int64_t random_start_epoch(void) {
+    return timestamp_from_time(get_today_midnight());
+}
+
+// Destination for read_csv_readings() while the ingest engine streams batches
+typedef struct {
+    Reading *readings;
+    int capacity;
+    int count;
+} CsvTarget;
+
+static bool copy_batch(const Reading *batch, int count, void *user_data) {
+    CsvTarget *target = user_data;
+    int room = target->capacity - target->count;
+    if (count > room) count = room;
+
+    memcpy(target->readings + target->count, batch, sizeof(Reading) * count);
+    target->count += count;
+    return target->count < target->capacity;  // Stop once the array is full
+}
+
+// Loads up to n readings from a CSV file, returns the number loaded or -1 if it cannot be opened
+int read_csv_readings(const char *filename, Reading *readings, int n) {
+    CsvTarget target = { readings, n, 0 };
+    IngestResult result;
+
+    if (n <= 0) return 0;
+    if (!csv_ingest_file(filename, copy_batch, &target, &result) && !result.stopped) return -1;
+
+    return target.count;  // Incomplete lines were skipped by the ingest engine
 }
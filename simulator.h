@@ -4,17 +4,26 @@
 #define SIMULATOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // Declaration of structure to store temperature and humidity readings
 typedef struct {
     int seq_no;
     char timestamp[32];
+    int64_t epoch;          // Same instant as timestamp, in timestamp.h seconds
     double temperature;
     double humidity;
+    int sensor_id;          // Probe that took the reading, 0 for single-sensor logs
 } Reading;
 
+// Growable reading container, defined in store.h
+typedef struct ReadingStore ReadingStore;
+
 // Declaration of required functions
 void generate_random_readings(Reading *readings, int n);
-bool read_csv_readings(const char *filename, Reading *readings, int n);
+int read_csv_readings(const char *filename, Reading *readings, int n);
+void generate_random_store(ReadingStore *store, size_t n);
+int64_t random_start_epoch(void);
 
 #endif
\ No newline at end of file
@@ -1,32 +1,559 @@
 // stats.c - Main Statistics Calculation Module
 
 #include "stats.h"
+#include "store.h"
+#include "timestamp.h"
+#include "platform.h"
+#include "instrument.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(STATS_NO_SIMD)
+#define STATS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Raw result of scanning one channel of a span. Sums are taken of (x - shift)
+// so that the variance can be derived in the same pass without cancellation.
+typedef struct {
+    double shift;
+    double sum, sum_sq;
+    double min, max;
+    size_t min_idx, max_idx;   // Relative to the start of the span
+} ChannelScan;
+
+typedef void (*ScanFn)(const double *temp, const double *humid, size_t n,
+                       ChannelScan *ts, ChannelScan *hs);
+
+static void scan_init(ChannelScan *s, double first) {
+    s->shift = first;
+    s->sum = s->sum_sq = 0;
+    s->min = s->max = first;
+    s->min_idx = s->max_idx = 0;
+}
+
+// Scalar step, also used for the tail of the vector kernels
+static inline void scan_one(ChannelScan *s, double x, size_t i) {
+    double d = x - s->shift;
+    s->sum += d;
+    s->sum_sq += d * d;
+    if (x < s->min) {
+        s->min = x;
+        s->min_idx = i;
+    }
+    if (x > s->max) {
+        s->max = x;
+        s->max_idx = i;
+    }
+}
+
+static void scan_scalar(const double *temp, const double *humid, size_t n,
+                        ChannelScan *ts, ChannelScan *hs) {
+    scan_init(ts, temp[0]);
+    scan_init(hs, humid[0]);
+    for (size_t i = 0; i < n; i++) {
+        scan_one(ts, temp[i], i);
+        scan_one(hs, humid[i], i);
+    }
+}
+
+#ifdef STATS_X86_SIMD
+
+// Folds one vector lane into the scan, keeping the first index on ties
+static void lane_merge(ChannelScan *s, double sum, double sum_sq, double mn, double mn_idx,
+                       double mx, double mx_idx) {
+    s->sum += sum;
+    s->sum_sq += sum_sq;
+    if (mn < s->min || (mn == s->min && (size_t)mn_idx < s->min_idx)) {
+        s->min = mn;
+        s->min_idx = (size_t)mn_idx;
+    }
+    if (mx > s->max || (mx == s->max && (size_t)mx_idx < s->max_idx)) {
+        s->max = mx;
+        s->max_idx = (size_t)mx_idx;
+    }
+}
+
+// SSE2: two doubles per step, blends done with and/andnot/or
+typedef struct {
+    __m128d shift, sum, sum_sq, min, max, min_idx, max_idx;
+} Sse2Lanes;
+
+__attribute__((target("sse2")))
+static inline void sse2_init(Sse2Lanes *l, double first) {
+    l->shift = l->min = l->max = _mm_set1_pd(first);
+    l->sum = l->sum_sq = l->min_idx = l->max_idx = _mm_setzero_pd();
+}
+
+__attribute__((target("sse2")))
+static inline void sse2_step(Sse2Lanes *l, __m128d x, __m128d idx) {
+    __m128d d = _mm_sub_pd(x, l->shift);
+    l->sum = _mm_add_pd(l->sum, d);
+    l->sum_sq = _mm_add_pd(l->sum_sq, _mm_mul_pd(d, d));
+
+    __m128d lt = _mm_cmplt_pd(x, l->min);
+    l->min = _mm_or_pd(_mm_and_pd(lt, x), _mm_andnot_pd(lt, l->min));
+    l->min_idx = _mm_or_pd(_mm_and_pd(lt, idx), _mm_andnot_pd(lt, l->min_idx));
+
+    __m128d gt = _mm_cmpgt_pd(x, l->max);
+    l->max = _mm_or_pd(_mm_and_pd(gt, x), _mm_andnot_pd(gt, l->max));
+    l->max_idx = _mm_or_pd(_mm_and_pd(gt, idx), _mm_andnot_pd(gt, l->max_idx));
+}
+
+__attribute__((target("sse2")))
+static void sse2_reduce(const Sse2Lanes *l, ChannelScan *s) {
+    double sum[2], sum_sq[2], mn[2], mn_idx[2], mx[2], mx_idx[2];
+    _mm_storeu_pd(sum, l->sum);
+    _mm_storeu_pd(sum_sq, l->sum_sq);
+    _mm_storeu_pd(mn, l->min);
+    _mm_storeu_pd(mn_idx, l->min_idx);
+    _mm_storeu_pd(mx, l->max);
+    _mm_storeu_pd(mx_idx, l->max_idx);
+    for (int k = 0; k < 2; k++) {
+        lane_merge(s, sum[k], sum_sq[k], mn[k], mn_idx[k], mx[k], mx_idx[k]);
+    }
+}
+
+__attribute__((target("sse2")))
+static void scan_sse2(const double *temp, const double *humid, size_t n,
+                      ChannelScan *ts, ChannelScan *hs) {
+    Sse2Lanes lt, lh;
+    size_t i = 0;
+
+    scan_init(ts, temp[0]);
+    scan_init(hs, humid[0]);
+    sse2_init(&lt, temp[0]);
+    sse2_init(&lh, humid[0]);
+
+    __m128d idx = _mm_set_pd(1.0, 0.0);
+    const __m128d step = _mm_set1_pd(2.0);
+    for (; i + 2 <= n; i += 2) {
+        sse2_step(&lt, _mm_loadu_pd(temp + i), idx);
+        sse2_step(&lh, _mm_loadu_pd(humid + i), idx);
+        idx = _mm_add_pd(idx, step);
+    }
+
+    sse2_reduce(&lt, ts);
+    sse2_reduce(&lh, hs);
+    for (; i < n; i++) {
+        scan_one(ts, temp[i], i);
+        scan_one(hs, humid[i], i);
+    }
+}
+
+// AVX2: four doubles per step
+typedef struct {
+    __m256d shift, sum, sum_sq, min, max, min_idx, max_idx;
+} Avx2Lanes;
+
+__attribute__((target("avx2")))
+static inline void avx2_init(Avx2Lanes *l, double first) {
+    l->shift = l->min = l->max = _mm256_set1_pd(first);
+    l->sum = l->sum_sq = l->min_idx = l->max_idx = _mm256_setzero_pd();
+}
+
+__attribute__((target("avx2")))
+static inline void avx2_step(Avx2Lanes *l, __m256d x, __m256d idx) {
+    __m256d d = _mm256_sub_pd(x, l->shift);
+    l->sum = _mm256_add_pd(l->sum, d);
+    l->sum_sq = _mm256_add_pd(l->sum_sq, _mm256_mul_pd(d, d));
+
+    __m256d lt = _mm256_cmp_pd(x, l->min, _CMP_LT_OQ);
+    l->min = _mm256_blendv_pd(l->min, x, lt);
+    l->min_idx = _mm256_blendv_pd(l->min_idx, idx, lt);
+
+    __m256d gt = _mm256_cmp_pd(x, l->max, _CMP_GT_OQ);
+    l->max = _mm256_blendv_pd(l->max, x, gt);
+    l->max_idx = _mm256_blendv_pd(l->max_idx, idx, gt);
+}
+
+__attribute__((target("avx2")))
+static void avx2_reduce(const Avx2Lanes *l, ChannelScan *s) {
+    double sum[4], sum_sq[4], mn[4], mn_idx[4], mx[4], mx_idx[4];
+    _mm256_storeu_pd(sum, l->sum);
+    _mm256_storeu_pd(sum_sq, l->sum_sq);
+    _mm256_storeu_pd(mn, l->min);
+    _mm256_storeu_pd(mn_idx, l->min_idx);
+    _mm256_storeu_pd(mx, l->max);
+    _mm256_storeu_pd(mx_idx, l->max_idx);
+    for (int k = 0; k < 4; k++) {
+        lane_merge(s, sum[k], sum_sq[k], mn[k], mn_idx[k], mx[k], mx_idx[k]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void scan_avx2(const double *temp, const double *humid, size_t n,
+                      ChannelScan *ts, ChannelScan *hs) {
+    Avx2Lanes lt, lh;
+    size_t i = 0;
+
+    scan_init(ts, temp[0]);
+    scan_init(hs, humid[0]);
+    avx2_init(&lt, temp[0]);
+    avx2_init(&lh, humid[0]);
+
+    // Lane indices are exact as doubles up to 2^53, far beyond a chunk
+    __m256d idx = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d step = _mm256_set1_pd(4.0);
+    for (; i + 4 <= n; i += 4) {
+        avx2_step(&lt, _mm256_loadu_pd(temp + i), idx);
+        avx2_step(&lh, _mm256_loadu_pd(humid + i), idx);
+        idx = _mm256_add_pd(idx, step);
+    }
+
+    avx2_reduce(&lt, ts);
+    avx2_reduce(&lh, hs);
+    for (; i < n; i++) {
+        scan_one(ts, temp[i], i);
+        scan_one(hs, humid[i], i);
+    }
+}
+
+#endif // STATS_X86_SIMD
+
+static ScanFn scan_kernel = NULL;
+static const char *scan_kernel_name = "scalar";
+
+// Picks the widest kernel the CPU supports, once
+static ScanFn resolve_kernel(void) {
+    if (scan_kernel) return scan_kernel;
+
+    ScanFn fn = scan_scalar;
+    const char *name = "scalar";
+#ifdef STATS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        fn = scan_avx2;
+        name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        fn = scan_sse2;
+        name = "sse2";
+    }
+#endif
+    scan_kernel_name = name;
+    scan_kernel = fn;
+    return fn;
+}
+
+// Name of the statistics kernel selected for this CPU
+const char *stats_kernel_name(void) {
+    resolve_kernel();
+    return scan_kernel_name;
+}
+
+static void agg_from_scan(const ChannelScan *s, size_t n, size_t base, ChannelAgg *a) {
+    a->count = n;
+    a->sum = s->shift * n + s->sum;
+    a->sum_comp = 0;
+    a->mean = s->shift + s->sum / n;
+    a->m2 = s->sum_sq - s->sum * s->sum / n;
+    if (a->m2 < 0) a->m2 = 0;  // Rounding on constant data
+    a->min = s->min;
+    a->max = s->max;
+    a->min_idx = base + s->min_idx;
+    a->max_idx = base + s->max_idx;
+}
+
+// Neumaier's variant of Kahan summation, also correct when x outweighs the sum
+static void kahan_add(double *sum, double *comp, double x) {
+    double t = *sum + x;
+    if (fabs(*sum) >= fabs(x)) {
+        *comp += (*sum - t) + x;
+    } else {
+        *comp += (x - t) + *sum;
+    }
+    *sum = t;
+}
+
+// Merges b into a, b must cover readings after the ones in a
+static void agg_merge(ChannelAgg *a, const ChannelAgg *b) {
+    if (b->count == 0) return;
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    size_t n = a->count + b->count;
+    double delta = b->mean - a->mean;
+    a->mean += delta * b->count / n;
+    a->m2 += b->m2 + delta * delta * ((double)a->count * b->count / n);
+    kahan_add(&a->sum, &a->sum_comp, b->sum);
+    a->sum_comp += b->sum_comp;
+    a->count = n;
+
+    if (b->min < a->min) {
+        a->min = b->min;
+        a->min_idx = b->min_idx;
+    }
+    if (b->max > a->max) {
+        a->max = b->max;
+        a->max_idx = b->max_idx;
+    }
+}
+
+// Writes the numeric fields, timestamps are left to the caller
+static void fill_statistics(const ChannelAgg *t, const ChannelAgg *h, Statistics *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->count = (long long)t->count;
+    if (t->count == 0) return;
+
+    stats->avg_temp = t->mean;
+    stats->avg_humid = h->mean;
+    stats->sum_temp = t->sum + t->sum_comp;
+    stats->sum_humid = h->sum + h->sum_comp;
+    stats->min_temp = t->min;
+    stats->max_temp = t->max;
+    stats->min_humid = h->min;
+    stats->max_humid = h->max;
+    stats->min_temp_idx = (long long)t->min_idx;
+    stats->max_temp_idx = (long long)t->max_idx;
+    stats->min_humid_idx = (long long)h->min_idx;
+    stats->max_humid_idx = (long long)h->max_idx;
+    stats->var_temp = t->m2 / t->count;
+    stats->var_humid = h->m2 / h->count;
+    stats->stddev_temp = sqrt(stats->var_temp);
+    stats->stddev_humid = sqrt(stats->var_humid);
+}
+
 // main funcution to calculate statistical values
 void calc_statistics(const Reading *readings, int n, Statistics *stats) {
-    double sum_temp = 0, sum_humid = 0;
-    
-    stats->max_temp = readings[0].temperature;
-    strcpy(stats->max_temp_ts, readings[0].timestamp);
-    stats->max_humid = readings[0].humidity;
-    strcpy(stats->max_humid_ts, readings[0].timestamp);
-
-    // Single pass through all readings to calculate sums and find maximums
-    for (int i = 0; i < n; i++) {
-        sum_temp += readings[i].temperature;
-        sum_humid += readings[i].humidity;
-        
-        if (readings[i].temperature > stats->max_temp) {
-            stats->max_temp = readings[i].temperature;
-            strcpy(stats->max_temp_ts, readings[i].timestamp);
-        }
-        if (readings[i].humidity > stats->max_humid) {
-            stats->max_humid = readings[i].humidity;
-            strcpy(stats->max_humid_ts, readings[i].timestamp);
+    INSTRUMENT_SCOPE(PROBE_CALC_STATISTICS);
+    ChannelAgg t = {0}, h = {0};
+
+    if (n > 0) {
+        // Reading is an array of structures, so this path stays scalar
+        ChannelScan ts, hs;
+        scan_init(&ts, readings[0].temperature);
+        scan_init(&hs, readings[0].humidity);
+
+        // Single pass through all readings for sums, extremes and variance
+        for (int i = 0; i < n; i++) {
+            scan_one(&ts, readings[i].temperature, (size_t)i);
+            scan_one(&hs, readings[i].humidity, (size_t)i);
         }
+        agg_from_scan(&ts, (size_t)n, 0, &t);
+        agg_from_scan(&hs, (size_t)n, 0, &h);
+    }
+
+    fill_statistics(&t, &h, stats);
+    if (n <= 0) return;
+
+    // Timestamps are copied once at the end rather than on every new extreme
+    strcpy(stats->min_temp_ts, readings[t.min_idx].timestamp);
+    strcpy(stats->max_temp_ts, readings[t.max_idx].timestamp);
+    strcpy(stats->min_humid_ts, readings[h.min_idx].timestamp);
+    strcpy(stats->max_humid_ts, readings[h.max_idx].timestamp);
+}
+
+// Aggregates readings [first, first + count) of a store, chunk segment by chunk segment
+void stats_partial_range(const ReadingStore *store, size_t first, size_t count, StatsPartial *out) {
+    ScanFn scan = resolve_kernel();
+    memset(out, 0, sizeof(*out));
+
+    size_t end = first + count;
+    if (end > store->count) end = store->count;
+
+    while (first < end) {
+        size_t c = first >> STORE_CHUNK_SHIFT;
+        size_t slot = store_slot(first);
+        size_t len = STORE_CHUNK_SIZE - slot;
+        if (len > end - first) len = end - first;
+
+        ChannelScan ts, hs;
+        StatsPartial part;
+        scan(store->chunks[c].temperature + slot, store->chunks[c].humidity + slot, len, &ts, &hs);
+        agg_from_scan(&ts, len, first, &part.temp);
+        agg_from_scan(&hs, len, first, &part.humid);
+        stats_partial_merge(out, &part);
+
+        first += len;
+    }
+}
+
+// Merges b into a, b must cover readings that come after the ones in a
+void stats_partial_merge(StatsPartial *a, const StatsPartial *b) {
+    agg_merge(&a->temp, &b->temp);
+    agg_merge(&a->humid, &b->humid);
+}
+
+// Turns a partial into Statistics, resolving the extreme timestamps from the store
+void stats_partial_finish(const StatsPartial *p, const ReadingStore *store, Statistics *stats) {
+    fill_statistics(&p->temp, &p->humid, stats);
+    if (p->temp.count == 0) return;
+
+    timestamp_format(store_epoch(store, p->temp.min_idx), stats->min_temp_ts);
+    timestamp_format(store_epoch(store, p->temp.max_idx), stats->max_temp_ts);
+    timestamp_format(store_epoch(store, p->humid.min_idx), stats->min_humid_ts);
+    timestamp_format(store_epoch(store, p->humid.max_idx), stats->max_humid_ts);
+}
+
+// Same as calc_statistics() over every reading in a store. Each chunk is scanned
+// with the vector kernel, the winning timestamps are formatted once at the end.
+// Chunks are merged in order, exactly as calc_statistics_parallel() does.
+void calc_statistics_store(const ReadingStore *store, Statistics *stats) {
+    INSTRUMENT_SCOPE(PROBE_CALC_STATISTICS);
+    StatsPartial total, part;
+    memset(&total, 0, sizeof(total));
+
+    for (size_t c = 0; c < store->chunk_count; c++) {
+        size_t len = store_chunk_length(store, c);
+        if (len == 0) break;
+        stats_partial_range(store, c << STORE_CHUNK_SHIFT, len, &part);
+        stats_partial_merge(&total, &part);
+    }
+
+    stats_partial_finish(&total, store, stats);
+}
+
+// Work shared by the statistics threads. Chunks are claimed from an atomic
+// counter but each result lands in its own slot, so the merge order (and with
+// it every rounding step) does not depend on the number of threads.
+typedef struct {
+    const ReadingStore *store;
+    StatsPartial *partials;
+    size_t chunks;
+    atomic_size_t next;
+} ParallelJob;
+
+static void *stats_worker(void *arg) {
+    ParallelJob *job = arg;
+
+    for (;;) {
+        size_t c = atomic_fetch_add(&job->next, 1);
+        if (c >= job->chunks) break;
+        stats_partial_range(job->store, c << STORE_CHUNK_SHIFT,
+                            store_chunk_length(job->store, c), &job->partials[c]);
     }
-    
-    stats->avg_temp = sum_temp / n;
-    stats->avg_humid = sum_humid / n;
-}
\ No newline at end of file
+    return NULL;
+}
+
+// Multi-threaded calc_statistics_store(), threads <= 0 uses one thread per CPU.
+// Results are bit-for-bit identical to the single-threaded version.
+void calc_statistics_parallel(const ReadingStore *store, int threads, Statistics *stats) {
+    size_t chunks = (store->count + STORE_CHUNK_SIZE - 1) >> STORE_CHUNK_SHIFT;
+    if (threads <= 0) threads = cpu_count();
+    if ((size_t)threads > chunks) threads = (int)chunks;
+
+    ParallelJob job;
+    job.store = store;
+    job.chunks = chunks;
+    job.partials = threads > 1 ? calloc(chunks, sizeof(StatsPartial)) : NULL;
+    pthread_t *tids = threads > 1 ? malloc(sizeof(pthread_t) * (size_t)(threads - 1)) : NULL;
+    if (!job.partials || !tids) {
+        // Small input or out of memory, the serial path gives the same answer
+        free(job.partials);
+        free(tids);
+        calc_statistics_store(store, stats);
+        return;
+    }
+    INSTRUMENT_SCOPE(PROBE_CALC_STATISTICS);  // After the serial fallback, which records itself
+    atomic_init(&job.next, 0);
+    resolve_kernel();  // Resolve once before the workers race for it
+
+    // The calling thread works too, so threads - 1 helpers are started
+    int started = 0;
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&tids[i], NULL, stats_worker, &job) != 0) break;
+        started++;
+    }
+    stats_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    StatsPartial total;
+    memset(&total, 0, sizeof(total));
+    for (size_t c = 0; c < chunks; c++) {
+        stats_partial_merge(&total, &job.partials[c]);
+    }
+    stats_partial_finish(&total, store, stats);
+
+    free(job.partials);
+    free(tids);
+}
+
+void running_stats_reset(RunningStats *rs) {
+    memset(rs, 0, sizeof(*rs));
+}
+
+// Adds one reading, constant time: Welford update plus extreme and alert bookkeeping
+void running_stats_add(RunningStats *rs, int64_t epoch, double temperature, double humidity,
+                       AlertLevel temp_level, AlertLevel humid_level) {
+    long long idx = rs->count++;
+
+    if (idx == 0) {
+        rs->min_temp = rs->max_temp = temperature;
+        rs->min_humid = rs->max_humid = humidity;
+        rs->min_temp_epoch = rs->max_temp_epoch = epoch;
+        rs->min_humid_epoch = rs->max_humid_epoch = epoch;
+    }
+
+    double dt = temperature - rs->mean_temp;
+    rs->mean_temp += dt / rs->count;
+    rs->m2_temp += dt * (temperature - rs->mean_temp);
+
+    double dh = humidity - rs->mean_humid;
+    rs->mean_humid += dh / rs->count;
+    rs->m2_humid += dh * (humidity - rs->mean_humid);
+
+    rs->sum_temp += temperature;
+    rs->sum_humid += humidity;
+
+    if (temperature < rs->min_temp) {
+        rs->min_temp = temperature;
+        rs->min_temp_epoch = epoch;
+        rs->min_temp_idx = idx;
+    }
+    if (temperature > rs->max_temp) {
+        rs->max_temp = temperature;
+        rs->max_temp_epoch = epoch;
+        rs->max_temp_idx = idx;
+    }
+    if (humidity < rs->min_humid) {
+        rs->min_humid = humidity;
+        rs->min_humid_epoch = epoch;
+        rs->min_humid_idx = idx;
+    }
+    if (humidity > rs->max_humid) {
+        rs->max_humid = humidity;
+        rs->max_humid_epoch = epoch;
+        rs->max_humid_idx = idx;
+    }
+
+    if (temp_level == LEVEL_ALERT) rs->temp_alerts++;
+    else if (temp_level == LEVEL_WARNING) rs->temp_warnings++;
+    if (humid_level == LEVEL_ALERT) rs->humid_alerts++;
+    else if (humid_level == LEVEL_WARNING) rs->humid_warnings++;
+}
+
+// Current aggregates as Statistics, timestamps are formatted here only
+void running_stats_snapshot(const RunningStats *rs, Statistics *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->count = rs->count;
+    if (rs->count == 0) return;
+
+    stats->avg_temp = rs->mean_temp;
+    stats->avg_humid = rs->mean_humid;
+    stats->sum_temp = rs->sum_temp;
+    stats->sum_humid = rs->sum_humid;
+    stats->min_temp = rs->min_temp;
+    stats->max_temp = rs->max_temp;
+    stats->min_humid = rs->min_humid;
+    stats->max_humid = rs->max_humid;
+    stats->min_temp_idx = rs->min_temp_idx;
+    stats->max_temp_idx = rs->max_temp_idx;
+    stats->min_humid_idx = rs->min_humid_idx;
+    stats->max_humid_idx = rs->max_humid_idx;
+    stats->var_temp = rs->m2_temp / rs->count;
+    stats->var_humid = rs->m2_humid / rs->count;
+    stats->stddev_temp = sqrt(stats->var_temp);
+    stats->stddev_humid = sqrt(stats->var_humid);
+
+    timestamp_format(rs->min_temp_epoch, stats->min_temp_ts);
+    timestamp_format(rs->max_temp_epoch, stats->max_temp_ts);
+    timestamp_format(rs->min_humid_epoch, stats->min_humid_ts);
+    timestamp_format(rs->max_humid_epoch, stats->max_humid_ts);
+}
@@ -3,19 +3,87 @@
 #ifndef STATS_H
 #define STATS_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "simulator.h"
 
 // Declaration of structure to store stat values
 typedef struct {
-    double avg_temp;        
-    double avg_humid;       
-    double max_temp;        
-    char max_temp_ts[32];   
-    double max_humid;       
-    char max_humid_ts[32]; 
+    double avg_temp;
+    double avg_humid;
+    double max_temp;
+    char max_temp_ts[32];
+    double max_humid;
+    char max_humid_ts[32];
+
+    // Extended aggregates (variance is the population variance)
+    long long count;
+    double sum_temp;
+    double sum_humid;
+    double min_temp;
+    char min_temp_ts[32];
+    double min_humid;
+    char min_humid_ts[32];
+    long long min_temp_idx, max_temp_idx;     // Index of the first reading with that value
+    long long min_humid_idx, max_humid_idx;
+    double var_temp, stddev_temp;
+    double var_humid, stddev_humid;
 } Statistics;
 
+// Declaration of partial aggregates for one channel over a contiguous range of
+// readings. Partials of consecutive ranges are merged in order, using the
+// Chan et al. update for the variance and a compensated (Kahan) sum.
+typedef struct {
+    size_t count;
+    double sum, sum_comp;     // Sum and its running compensation term
+    double mean, m2;          // m2 = sum of squared deviations from the mean
+    double min, max;
+    size_t min_idx, max_idx;  // Absolute reading index
+} ChannelAgg;
+
+typedef struct {
+    ChannelAgg temp;
+    ChannelAgg humid;
+} StatsPartial;
+
+// Declaration of alert levels, shared by the status logic and the alert counters
+typedef enum {
+    LEVEL_SAFE,
+    LEVEL_WARNING,
+    LEVEL_ALERT
+} AlertLevel;
+
+// Declaration of incremental statistics, updated in O(1) as each reading arrives
+typedef struct {
+    long long count;
+    double mean_temp, m2_temp;       // Welford running mean and squared deviations
+    double mean_humid, m2_humid;
+    double sum_temp, sum_humid;
+    double min_temp, max_temp;
+    double min_humid, max_humid;
+    int64_t min_temp_epoch, max_temp_epoch;
+    int64_t min_humid_epoch, max_humid_epoch;
+    long long min_temp_idx, max_temp_idx;
+    long long min_humid_idx, max_humid_idx;
+    long long temp_warnings, temp_alerts;
+    long long humid_warnings, humid_alerts;
+} RunningStats;
+
 // Declaration of main stat function
 void calc_statistics(const Reading *readings, int n, Statistics *stats);
+void calc_statistics_store(const ReadingStore *store, Statistics *stats);
+void calc_statistics_parallel(const ReadingStore *store, int threads, Statistics *stats);
+const char *stats_kernel_name(void);
+
+// Building blocks for statistics over parts of a store
+void stats_partial_range(const ReadingStore *store, size_t first, size_t count, StatsPartial *out);
+void stats_partial_merge(StatsPartial *a, const StatsPartial *b);
+void stats_partial_finish(const StatsPartial *p, const ReadingStore *store, Statistics *stats);
+
+// Incremental statistics
+void running_stats_reset(RunningStats *rs);
+void running_stats_add(RunningStats *rs, int64_t epoch, double temperature, double humidity,
+                       AlertLevel temp_level, AlertLevel humid_level);
+void running_stats_snapshot(const RunningStats *rs, Statistics *stats);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,122 @@
+// store.c - Chunked Append-Only Columnar Reading Store Module
+
+#include "store.h"
+#include "timestamp.h"
+#include <stdlib.h>
+#include <string.h>
+
+void store_init(ReadingStore *store) {
+    memset(store, 0, sizeof(*store));
+}
+
+// Releases every chunk and leaves the store empty
+void store_free(ReadingStore *store) {
+    for (size_t c = 0; c < store->chunk_count; c++) {
+        free(store->chunks[c].epoch);  // Start of the chunk's single allocation
+    }
+    free(store->chunks);
+    store_init(store);
+}
+
+// Forgets all readings but keeps the chunks allocated for the next run
+void store_clear(ReadingStore *store) {
+    store->count = 0;
+}
+
+// Allocates all five columns of a chunk in one block, widest column first
+static bool alloc_chunk(StoreChunk *chunk) {
+    size_t n = STORE_CHUNK_SIZE;
+    char *block = malloc(n * (sizeof(int64_t) + 2 * sizeof(double) + sizeof(int) + sizeof(int32_t)));
+    if (!block) return false;
+
+    chunk->epoch = (int64_t *)block;
+    chunk->temperature = (double *)(block + n * sizeof(int64_t));
+    chunk->humidity = (double *)(block + n * (sizeof(int64_t) + sizeof(double)));
+    chunk->seq_no = (int *)(block + n * (sizeof(int64_t) + 2 * sizeof(double)));
+    chunk->sensor_id = (int32_t *)(block + n * (sizeof(int64_t) + 2 * sizeof(double) + sizeof(int)));
+    return true;
+}
+
+// Appends one reading of the default sensor (0), returns false if memory is exhausted
+bool store_append(ReadingStore *store, int seq_no, int64_t epoch, double temperature, double humidity) {
+    return store_append_sensor(store, seq_no, epoch, temperature, humidity, 0);
+}
+
+// Makes sure the chunk that holds index count exists
+static bool ensure_chunk(ReadingStore *store) {
+    size_t chunk = store->count >> STORE_CHUNK_SHIFT;
+    if (chunk < store->chunk_count) return true;
+
+    if (store->chunk_count == store->chunk_capacity) {
+        // Growing the directory copies chunk pointers only, never readings
+        size_t capacity = store->chunk_capacity ? store->chunk_capacity * 2 : 16;
+        StoreChunk *chunks = realloc(store->chunks, capacity * sizeof(StoreChunk));
+        if (!chunks) return false;
+        store->chunks = chunks;
+        store->chunk_capacity = capacity;
+    }
+
+    if (!alloc_chunk(&store->chunks[store->chunk_count])) return false;
+    store->chunk_count++;
+    return true;
+}
+
+// Appends one reading taken by sensor_id
+bool store_append_sensor(ReadingStore *store, int seq_no, int64_t epoch, double temperature, double humidity,
+                         int sensor_id) {
+    if (!ensure_chunk(store)) return false;
+
+    StoreChunk *c = &store->chunks[store->count >> STORE_CHUNK_SHIFT];
+    size_t slot = store_slot(store->count);
+    c->epoch[slot] = epoch;
+    c->temperature[slot] = temperature;
+    c->humidity[slot] = humidity;
+    c->seq_no[slot] = seq_no;
+    c->sensor_id[slot] = sensor_id;
+    store->count++;
+    return true;
+}
+
+// Appends n readings given as columns, copying whole runs with memcpy.
+// Returns the number appended, less than n only if memory is exhausted.
+size_t store_append_block(ReadingStore *store, const int64_t *epoch, const double *temperature,
+                          const double *humidity, const int *seq_no, const int32_t *sensor_id, size_t n) {
+    size_t done = 0;
+
+    while (done < n) {
+        if (!ensure_chunk(store)) break;
+
+        StoreChunk *c = &store->chunks[store->count >> STORE_CHUNK_SHIFT];
+        size_t slot = store_slot(store->count);
+        size_t run = STORE_CHUNK_SIZE - slot;  // Room left in this chunk
+        if (run > n - done) run = n - done;
+
+        memcpy(c->epoch + slot, epoch + done, run * sizeof(int64_t));
+        memcpy(c->temperature + slot, temperature + done, run * sizeof(double));
+        memcpy(c->humidity + slot, humidity + done, run * sizeof(double));
+        memcpy(c->seq_no + slot, seq_no + done, run * sizeof(int));
+        memcpy(c->sensor_id + slot, sensor_id + done, run * sizeof(int32_t));
+        store->count += run;
+        done += run;
+    }
+    return done;
+}
+
+// Appends a Reading, returns false if memory is exhausted
+bool store_push(ReadingStore *store, const Reading *reading) {
+    return store_append_sensor(store, reading->seq_no, reading->epoch, reading->temperature, reading->humidity,
+                               reading->sensor_id);
+}
+
+// Rebuilds the Reading at index i, formatting its timestamp on the fly
+void store_get(const ReadingStore *store, size_t i, Reading *out) {
+    const StoreChunk *c = store_chunk_of(store, i);
+    size_t slot = store_slot(i);
+
+    out->seq_no = c->seq_no[slot];
+    out->epoch = c->epoch[slot];
+    timestamp_format(out->epoch, out->timestamp);
+    out->temperature = c->temperature[slot];
+    out->humidity = c->humidity[slot];
+    out->sensor_id = c->sensor_id[slot];
+}
@@ -0,0 +1,85 @@
+// store.h - Declaration of store.c functions and structures
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+
+#define STORE_CHUNK_SHIFT 16                         // 65536 readings per chunk
+#define STORE_CHUNK_SIZE ((size_t)1 << STORE_CHUNK_SHIFT)
+
+// Declaration of one chunk of column arrays (structure of arrays). Timestamps
+// are kept as wall-clock epoch seconds and formatted only when displayed.
+typedef struct {
+    int64_t *epoch;
+    double *temperature;
+    double *humidity;
+    int *seq_no;
+    int32_t *sensor_id;
+} StoreChunk;
+
+// Declaration of append-only columnar reading store. Columns live in fixed-size
+// chunks that are never moved, so pointers into them stay valid until the store
+// is freed. A zero-initialised store is empty and ready to use.
+struct ReadingStore {
+    StoreChunk *chunks;      // Chunk directory, the only array that is ever reallocated
+    size_t chunk_count;      // Chunks allocated so far
+    size_t chunk_capacity;   // Slots in the chunk directory
+    size_t count;            // Readings stored
+};
+
+// Declaration of required functions
+void store_init(ReadingStore *store);
+void store_free(ReadingStore *store);
+void store_clear(ReadingStore *store);
+bool store_append(ReadingStore *store, int seq_no, int64_t epoch, double temperature, double humidity);
+bool store_append_sensor(ReadingStore *store, int seq_no, int64_t epoch, double temperature, double humidity,
+                         int sensor_id);
+size_t store_append_block(ReadingStore *store, const int64_t *epoch, const double *temperature,
+                          const double *humidity, const int *seq_no, const int32_t *sensor_id, size_t n);
+
+// Adapters for the Reading based APIs (timestamps are parsed / formatted here)
+bool store_push(ReadingStore *store, const Reading *reading);
+void store_get(const ReadingStore *store, size_t i, Reading *out);
+
+// Chunk and column access, i must be below store->count
+static inline const StoreChunk *store_chunk_of(const ReadingStore *store, size_t i) {
+    return &store->chunks[i >> STORE_CHUNK_SHIFT];
+}
+
+static inline size_t store_slot(size_t i) {
+    return i & (STORE_CHUNK_SIZE - 1);
+}
+
+// Number of valid readings in chunk c
+static inline size_t store_chunk_length(const ReadingStore *store, size_t c) {
+    size_t first = c << STORE_CHUNK_SHIFT;
+    if (first >= store->count) return 0;
+    size_t len = store->count - first;
+    return len < STORE_CHUNK_SIZE ? len : STORE_CHUNK_SIZE;
+}
+
+static inline double store_temperature(const ReadingStore *store, size_t i) {
+    return store_chunk_of(store, i)->temperature[store_slot(i)];
+}
+
+static inline double store_humidity(const ReadingStore *store, size_t i) {
+    return store_chunk_of(store, i)->humidity[store_slot(i)];
+}
+
+static inline int64_t store_epoch(const ReadingStore *store, size_t i) {
+    return store_chunk_of(store, i)->epoch[store_slot(i)];
+}
+
+static inline int store_seq_no(const ReadingStore *store, size_t i) {
+    return store_chunk_of(store, i)->seq_no[store_slot(i)];
+}
+
+static inline int store_sensor_id(const ReadingStore *store, size_t i) {
+    return store_chunk_of(store, i)->sensor_id[store_slot(i)];
+}
+
+#endif
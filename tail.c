@@ -0,0 +1,207 @@
+// tail.c - Live CSV Tail Module
+
+#include "tail.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define tail_seek _fseeki64
+#define tail_tell _ftelli64
+#else
+#include <unistd.h>
+#define tail_seek fseeko
+#define tail_tell ftello
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#define TAIL_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+#endif
+
+// Starts (or restarts) watching the file for changes
+static void watch_start(TailReader *t) {
+#ifdef _WIN32
+    // Windows reports changes per directory, a change to any file in it wakes the reader
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s", t->filename);
+    char *slash = strrchr(dir, '\\');
+    char *fwd = strrchr(dir, '/');
+    if (fwd > slash) slash = fwd;
+    if (slash) *slash = '\0';
+    else strcpy(dir, ".");
+
+    HANDLE h = FindFirstChangeNotificationA(dir, FALSE, FILE_NOTIFY_CHANGE_SIZE |
+                                            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    t->change = h == INVALID_HANDLE_VALUE ? NULL : h;
+#elif defined(__linux__)
+    t->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (t->watch_fd >= 0 && inotify_add_watch(t->watch_fd, t->filename, TAIL_EVENTS) < 0) {
+        close(t->watch_fd);
+        t->watch_fd = -1;
+    }
+#else
+    t->watch_fd = -1;
+#endif
+}
+
+static void watch_stop(TailReader *t) {
+#ifdef _WIN32
+    if (t->change) FindCloseChangeNotification(t->change);
+    t->change = NULL;
+#else
+    if (t->watch_fd >= 0) close(t->watch_fd);
+    t->watch_fd = -1;
+#endif
+}
+
+// Unbuffered, so a rewound file is never served stale bytes from the stdio buffer;
+// reads are TAIL_READ_SIZE pieces anyway
+static FILE *open_unbuffered(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file) setvbuf(file, NULL, _IONBF, 0);
+    return file;
+}
+
+// Opens the file and reads it from the start on the first tail_poll()
+bool tail_open(TailReader *t, const char *filename) {
+    memset(t, 0, sizeof(*t));
+#ifndef _WIN32
+    t->watch_fd = -1;
+#endif
+    snprintf(t->filename, sizeof(t->filename), "%s", filename);
+    t->file = open_unbuffered(filename);
+    if (!t->file) return false;
+    file_id_open(t->file, &t->id);
+    watch_start(t);
+    return true;
+}
+
+void tail_close(TailReader *t) {
+    if (t->file) fclose(t->file);
+    watch_stop(t);
+    free(t->pending);
+    t->file = NULL;
+    t->pending = NULL;
+    t->pending_len = t->pending_capacity = 0;
+}
+
+// Starts over from the first byte, used after the file was truncated or replaced
+static void restart(TailReader *t) {
+    t->offset = 0;
+    t->pending_len = 0;
+    t->head_len = 0;
+}
+
+// True while the file still starts with the bytes read from it first. A logger that
+// truncates and writes past the old offset between two polls fails this check.
+static bool same_start(TailReader *t) {
+    if (t->head_len == 0) return true;
+    char head[TAIL_HEAD_SIZE];
+    if (tail_seek(t->file, 0, SEEK_SET) != 0) return true;
+    size_t got = fread(head, 1, t->head_len, t->file);
+    clearerr(t->file);
+    return got == t->head_len && memcmp(head, t->head, got) == 0;
+}
+
+// Keeps the first TAIL_HEAD_SIZE bytes of the file as they are read
+static void remember_head(TailReader *t, const char *data, size_t len) {
+    if (t->offset >= TAIL_HEAD_SIZE) return;
+    size_t n = TAIL_HEAD_SIZE - (size_t)t->offset;
+    if (n > len) n = len;
+    memcpy(t->head + t->offset, data, n);
+    t->head_len = (size_t)t->offset + n;
+}
+
+// Parses every complete line in pending and keeps the unfinished rest
+static bool parse_complete_lines(TailReader *t, ReadingBatchFn on_batch, void *user_data) {
+    size_t complete = t->pending_len;
+    while (complete > 0 && t->pending[complete - 1] != '\n') complete--;
+    if (complete == 0) return true;
+
+    bool keep_going = csv_ingest_buffer(t->pending, complete, on_batch, user_data, &t->totals);
+    t->pending_len -= complete;
+    memmove(t->pending, t->pending + complete, t->pending_len);
+    return keep_going;
+}
+
+// Reads the bytes appended since the last call and passes the complete lines to
+// on_batch. Returns false once on_batch asked to stop.
+bool tail_poll(TailReader *t, ReadingBatchFn on_batch, void *user_data) {
+    // A different file under the same name: replaced without a notification reaching us
+    FileId id;
+    if (!t->reopen && t->file && file_id(t->filename, &id) && !file_id_equal(&id, &t->id))
+        t->reopen = true;
+
+    if (t->reopen) {
+        // Moved or deleted: follow the new file of that name once it exists
+        FILE *file = open_unbuffered(t->filename);
+        if (!file) return true;
+        if (t->file) fclose(t->file);
+        t->file = file;
+        file_id_open(file, &t->id);
+        t->reopen = false;
+        watch_stop(t);
+        watch_start(t);
+        restart(t);
+    }
+    if (!t->file || tail_seek(t->file, 0, SEEK_END) != 0) return true;
+
+    int64_t size = (int64_t)tail_tell(t->file);
+    if (size < t->offset || !same_start(t)) restart(t);  // Truncated or rewritten, the logger started a new file
+    if (size == t->offset || tail_seek(t->file, t->offset, SEEK_SET) != 0) return true;
+
+    while (t->offset < size) {
+        size_t want = size - t->offset < TAIL_READ_SIZE ? (size_t)(size - t->offset) : TAIL_READ_SIZE;
+        if (t->pending_len + want > t->pending_capacity) {
+            size_t capacity = t->pending_len + want;
+            char *pending = realloc(t->pending, capacity);
+            if (!pending) return true;  // Retried on the next poll
+            t->pending = pending;
+            t->pending_capacity = capacity;
+        }
+
+        size_t got = fread(t->pending + t->pending_len, 1, want, t->file);
+        remember_head(t, t->pending + t->pending_len, got);
+        t->pending_len += got;
+        t->offset += (int64_t)got;
+        if (!parse_complete_lines(t, on_batch, user_data)) return false;
+        if (got < want) break;
+    }
+    clearerr(t->file);  // Reading up to the end sets EOF, more data may follow
+    return true;
+}
+
+// Blocks until the file may have changed or timeout_ms passed, returns true on a change.
+// Without a change notification it simply sleeps, callers poll after every wait anyway.
+bool tail_wait(TailReader *t, int timeout_ms) {
+#ifdef _WIN32
+    if (t->change) {
+        if (WaitForSingleObject(t->change, (DWORD)timeout_ms) != WAIT_OBJECT_0) return false;
+        FindNextChangeNotification(t->change);
+        return true;
+    }
+#elif defined(__linux__)
+    if (t->watch_fd >= 0) {
+        struct pollfd pfd = { t->watch_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+        // Drain the queued events, only moves and deletions need action
+        _Alignas(struct inotify_event) char events[4096];
+        ssize_t n;
+        while ((n = read(t->watch_fd, events, sizeof(events))) > 0) {
+            for (char *p = events; p < events + n; ) {
+                const struct inotify_event *ev = (const struct inotify_event *)p;
+                if (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) t->reopen = true;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        if (t->reopen) watch_stop(t);  // Re-armed once the file is back
+        return true;
+    }
+#endif
+    sleep_ms(timeout_ms);
+    return false;
+}
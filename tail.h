@@ -0,0 +1,44 @@
+// tail.h - Declaration of tail.c functions and structures
+
+#ifndef TAIL_H
+#define TAIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ingest.h"
+#include "platform.h"
+
+#define TAIL_READ_SIZE (1 << 20)   // Bytes read from the file per step
+#define TAIL_HEAD_SIZE 256         // Leading bytes kept to recognise a rewritten file
+
+// Declaration of structure following a CSV file that another program appends to.
+// Only bytes past `offset` are ever read; a line without its newline yet is kept
+// in `pending` until the rest of it arrives. The file's identity and its first
+// bytes are checked on every poll, so a replaced or rewritten file is read anew.
+typedef struct {
+    char filename[256];
+    FILE *file;               // Kept open between polls
+    int64_t offset;           // Bytes of the file read so far
+    char *pending;            // Read but not parsed: the unfinished last line
+    size_t pending_len;
+    size_t pending_capacity;
+    bool reopen;              // File was moved or deleted, open it again by name
+    FileId id;                // Identity of the open file
+    char head[TAIL_HEAD_SIZE];  // First bytes read, compared with the file on every poll
+    size_t head_len;
+    IngestResult totals;      // Rows parsed and skipped since tail_open()
+#ifdef _WIN32
+    void *change;             // Directory change notification handle
+#else
+    int watch_fd;             // inotify instance, -1 when not available
+#endif
+} TailReader;
+
+// Declaration of required functions
+bool tail_open(TailReader *t, const char *filename);
+void tail_close(TailReader *t);
+bool tail_poll(TailReader *t, ReadingBatchFn on_batch, void *user_data);
+bool tail_wait(TailReader *t, int timeout_ms);
+
+#endif
@@ -2,31 +2,50 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "rules.h"
 
-//gcc test.c -o test.exe
+//gcc test.c rules.c -o test.exe
 
-#define ALERT_THRESHOLD 65.0
-#define WARNING_THRESHOLD 60.0
 #define TEST_READINGS_COUNT 5
 
-typedef struct {
-    int seq_no;
-    char timestamp[32];
-    double temperature;
-    double humidity;
-} Reading;
-
-// Simple function to determine status using conditional logic
-void get_status(double value, char* status, const char* type) {
-    if (value > ALERT_THRESHOLD) {
+// Status text of a level, the same wording as the GUI
+void get_status(AlertLevel level, char* status, const char* type) {
+    if (level == LEVEL_ALERT) {
         sprintf(status, "Alert! Safe %s exceeded.", type);
-    } else if (value >= WARNING_THRESHOLD) {
+    } else if (level == LEVEL_WARNING) {
         sprintf(status, "Warning! Safe %s exceeding.", type);
     } else {
         sprintf(status, "Safe %s levels.", type);
     }
 }
 
+// Levels from the same rules as the GUI (rules.conf, or the built-in rules)
+int evaluate_rules(Reading readings[TEST_READINGS_COUNT], AlertLevel temp_levels[TEST_READINGS_COUNT],
+                   AlertLevel humid_levels[TEST_READINGS_COUNT]) {
+    RuleEngine engine;
+    int sensor_ids[TEST_READINGS_COUNT];
+    int64_t epochs[TEST_READINGS_COUNT];
+    double temperature[TEST_READINGS_COUNT], humidity[TEST_READINGS_COUNT];
+    int error_line;
+
+    rules_init(&engine);
+    if (!rules_load(&engine, RULES_FILE, &error_line)) {
+        if (error_line > 0) printf("%s:%d: invalid rule, using the built-in rules\n", RULES_FILE, error_line);
+        rules_defaults(&engine);
+    }
+    for (int i = 0; i < TEST_READINGS_COUNT; i++) {
+        sensor_ids[i] = readings[i].sensor_id;
+        epochs[i] = (int64_t)i * 60;  // Timestamps are one minute apart
+        temperature[i] = readings[i].temperature;
+        humidity[i] = readings[i].humidity;
+    }
+    int ok = rules_compile(&engine) &&
+             rules_eval(&engine, sensor_ids, epochs, temperature, humidity, temp_levels, humid_levels,
+                        TEST_READINGS_COUNT);
+    rules_free(&engine);
+    return ok;
+}
+
 //Dummy timestamp generation
 void generate_timestamp(char* timestamp, int seq) {
     time_t now = time(NULL);
@@ -44,6 +63,7 @@ void get_user_readings(Reading readings[TEST_READINGS_COUNT]) {
     
     for (int i = 0; i < TEST_READINGS_COUNT; i++) {
         readings[i].seq_no = i + 1;
+        readings[i].sensor_id = 0;
         
         printf("Reading %d:\n", i + 1);
         
@@ -101,6 +121,12 @@ int main() {
     printf("****************************************\n");
     printf("  READINGS TABLE\n");
     printf("****************************************\n");
+    AlertLevel temp_levels[TEST_READINGS_COUNT], humid_levels[TEST_READINGS_COUNT];
+    if (!evaluate_rules(readings, temp_levels, humid_levels)) {
+        printf("Out of memory evaluating the rules\n");
+        return 1;
+    }
+
     printf("%-4s | %-19s | %-8s | %-9s | %-35s | %-35s\n", 
            "Seq", "Timestamp", "Temp(C)", "Humid(%)", "Temp Status Expected", "Humid Status Expected");
     printf("-----+---------------------+----------+-----------+-------------------------------------+-------------------------------------\n");
@@ -108,8 +134,8 @@ int main() {
     for (int i = 0; i < TEST_READINGS_COUNT; i++) {
         char temp_status[50], humid_status[50];
         
-        get_status(readings[i].temperature, temp_status, "Temperature");
-        get_status(readings[i].humidity, humid_status, "Humidity");
+        get_status(temp_levels[i], temp_status, "Temperature");
+        get_status(humid_levels[i], humid_status, "Humidity");
         
         printf("%-4d | %-19s | %-8.2f | %-9.2f | %-35s | %-35s\n",
                readings[i].seq_no,
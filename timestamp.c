@@ -0,0 +1,118 @@
+// timestamp.c - Timestamp Parsing and Formatting Module
+
+#include "timestamp.h"
+#include "platform.h"
+
+#define SECONDS_PER_DAY 86400
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Inverse of days_from_civil()
+static void civil_from_days(int64_t z, int *year, int *month, int *day) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (int)(yoe + era * 400 + (*month <= 2));
+}
+
+// Reads exactly n digits as a number, returns -1 if any of them is not a digit
+static int read_digits(const char *p, int n) {
+    int value = 0;
+    for (int i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+static int days_in_month(int year, int month) {
+    static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : days[month - 1];
+}
+
+static void write_digits(char *out, int value, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+        out[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Parses "YYYY-MM-DD HH:MM" with optional ":SS", len receives the characters used
+bool timestamp_parse(const char *text, size_t avail, int64_t *epoch, size_t *len) {
+    const char *p = text;
+    if (avail < 16) return false;
+    if (p[4] != '-' || p[7] != '-' || p[10] != ' ' || p[13] != ':') return false;
+
+    int year = read_digits(p, 4), month = read_digits(p + 5, 2), day = read_digits(p + 8, 2);
+    int hour = read_digits(p + 11, 2), minute = read_digits(p + 14, 2), second = 0;
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        return false;  // 2024-02-31 is rejected rather than rolled over into March
+    }
+
+    *len = 16;
+    if (avail >= 19 && p[16] == ':') {
+        second = read_digits(p + 17, 2);
+        if (second < 0 || second > 60) return false;
+        *len = 19;
+    }
+
+    *epoch = days_from_civil(year, month, day) * SECONDS_PER_DAY +
+             hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+// Formats as "YYYY-MM-DD HH:MM" (plus ":SS" when non-zero), returns the length
+size_t timestamp_format(int64_t epoch, char *out) {
+    int64_t days = epoch / SECONDS_PER_DAY;
+    int64_t secs = epoch % SECONDS_PER_DAY;
+    if (secs < 0) {
+        secs += SECONDS_PER_DAY;
+        days--;
+    }
+
+    int year, month, day;
+    civil_from_days(days, &year, &month, &day);
+
+    write_digits(out, year, 4);
+    out[4] = '-';
+    write_digits(out + 5, month, 2);
+    out[7] = '-';
+    write_digits(out + 8, day, 2);
+    out[10] = ' ';
+    write_digits(out + 11, (int)(secs / 3600), 2);
+    out[13] = ':';
+    write_digits(out + 14, (int)(secs / 60 % 60), 2);
+
+    size_t len = 16;
+    if (secs % 60 != 0) {
+        out[16] = ':';
+        write_digits(out + 17, (int)(secs % 60), 2);
+        len = 19;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Converts a time_t to wall-clock seconds in the local timezone
+int64_t timestamp_from_time(time_t t) {
+    struct tm tm_info;
+    if (!platform_localtime(t, &tm_info)) return 0;
+    return days_from_civil(tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday) * SECONDS_PER_DAY +
+           tm_info.tm_hour * 3600 + tm_info.tm_min * 60 + tm_info.tm_sec;
+}
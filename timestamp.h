@@ -0,0 +1,21 @@
+// timestamp.h - Declaration of timestamp.c functions
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Timestamps are stored as wall-clock seconds since 1970-01-01 00:00, i.e. the
+// local date and time as written in the logs, without any timezone conversion.
+
+#define TIMESTAMP_LEN 32   // Buffer size for formatted timestamps (same as Reading)
+
+// Declaration of required functions
+bool timestamp_parse(const char *text, size_t avail, int64_t *epoch, size_t *len);
+size_t timestamp_format(int64_t epoch, char *out);
+int64_t timestamp_from_time(time_t t);
+
+#endif
@@ -0,0 +1,144 @@
+// tindex.c - Time Range Index Module
+
+#include "tindex.h"
+#include "store.h"
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(STORE_CHUNK_SHIFT >= TINDEX_BLOCK_SHIFT, "index blocks must not straddle store chunks");
+
+void tindex_init(TimeIndex *idx) {
+    memset(idx, 0, sizeof(*idx));
+    idx->sorted = true;
+}
+
+void tindex_free(TimeIndex *idx) {
+    free(idx->blocks);
+    tindex_init(idx);
+}
+
+// Forgets every block but keeps the allocation, for a store that was cleared
+void tindex_reset(TimeIndex *idx) {
+    idx->block_count = 0;
+    idx->indexed = 0;
+    idx->sorted = true;
+}
+
+// Indexes the whole blocks appended to the store since the last update
+bool tindex_update(TimeIndex *idx, const ReadingStore *store) {
+    while (store->count - idx->indexed >= TINDEX_BLOCK_SIZE) {
+        if (idx->block_count == idx->block_capacity) {
+            size_t capacity = idx->block_capacity ? idx->block_capacity * 2 : 64;
+            TimeIndexBlock *blocks = realloc(idx->blocks, capacity * sizeof(TimeIndexBlock));
+            if (!blocks) return false;
+            idx->blocks = blocks;
+            idx->block_capacity = capacity;
+        }
+
+        size_t first = idx->indexed;
+        const int64_t *epoch = store_chunk_of(store, first)->epoch + store_slot(first);
+        TimeIndexBlock *b = &idx->blocks[idx->block_count];
+
+        b->min_epoch = b->max_epoch = epoch[0];
+        bool sorted = idx->block_count == 0 || epoch[0] >= idx->blocks[idx->block_count - 1].max_epoch;
+        for (size_t i = 1; i < TINDEX_BLOCK_SIZE; i++) {
+            if (epoch[i] < epoch[i - 1]) sorted = false;
+            if (epoch[i] < b->min_epoch) b->min_epoch = epoch[i];
+            if (epoch[i] > b->max_epoch) b->max_epoch = epoch[i];
+        }
+        stats_partial_range(store, first, TINDEX_BLOCK_SIZE, &b->stats);
+
+        idx->sorted = idx->sorted && sorted;
+        idx->block_count++;
+        idx->indexed += TINDEX_BLOCK_SIZE;
+    }
+    return true;
+}
+
+// Adds every maximal run of readings in [first, end) with from <= epoch <= to
+static void scan_runs(const ReadingStore *store, size_t first, size_t end, int64_t from, int64_t to,
+                      StatsPartial *acc) {
+    size_t i = first;
+    while (i < end) {
+        while (i < end && (store_epoch(store, i) < from || store_epoch(store, i) > to)) i++;
+        size_t run = i;
+        while (i < end && store_epoch(store, i) >= from && store_epoch(store, i) <= to) i++;
+        if (i > run) {
+            StatsPartial part;
+            stats_partial_range(store, run, i - run, &part);
+            stats_partial_merge(acc, &part);
+        }
+    }
+}
+
+// First reading in [first, end) with epoch >= value, the range must be sorted
+static size_t lower_bound(const ReadingStore *store, size_t first, size_t end, int64_t value) {
+    while (first < end) {
+        size_t mid = first + (end - first) / 2;
+        if (store_epoch(store, mid) < value) first = mid + 1;
+        else end = mid;
+    }
+    return first;
+}
+
+// Adds one block, using its precomputed aggregates when the range covers it completely
+static void add_block(const TimeIndex *idx, const ReadingStore *store, size_t b, int64_t from, int64_t to,
+                      StatsPartial *acc) {
+    const TimeIndexBlock *blk = &idx->blocks[b];
+    if (blk->max_epoch < from || blk->min_epoch > to) return;
+
+    if (blk->min_epoch >= from && blk->max_epoch <= to) {
+        stats_partial_merge(acc, &blk->stats);
+        return;
+    }
+
+    size_t first = b << TINDEX_BLOCK_SHIFT;
+    size_t end = first + TINDEX_BLOCK_SIZE;
+    if (idx->sorted) {
+        // Range ends inside this block, the matching readings are contiguous
+        size_t lo = lower_bound(store, first, end, from);
+        size_t hi = to == INT64_MAX ? end : lower_bound(store, lo, end, to + 1);
+        if (hi > lo) {
+            StatsPartial part;
+            stats_partial_range(store, lo, hi - lo, &part);
+            stats_partial_merge(acc, &part);
+        }
+    } else {
+        scan_runs(store, first, end, from, to, acc);
+    }
+}
+
+// Aggregates readings with from <= epoch <= to, merged in store order. Whole
+// blocks inside the range cost one merge, blocks outside it are skipped.
+void tindex_query_partial(const TimeIndex *idx, const ReadingStore *store, int64_t from, int64_t to,
+                          StatsPartial *out) {
+    memset(out, 0, sizeof(*out));
+    if (from > to) return;
+
+    if (idx->sorted) {
+        // Block spans do not overlap, so binary search finds the first candidate
+        size_t lo = 0, hi = idx->block_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (idx->blocks[mid].max_epoch < from) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t b = lo; b < idx->block_count && idx->blocks[b].min_epoch <= to; b++) {
+            add_block(idx, store, b, from, to, out);
+        }
+    } else {
+        for (size_t b = 0; b < idx->block_count; b++) {
+            add_block(idx, store, b, from, to, out);
+        }
+    }
+
+    // Readings not indexed yet
+    scan_runs(store, idx->indexed, store->count, from, to, out);
+}
+
+void tindex_query(const TimeIndex *idx, const ReadingStore *store, int64_t from, int64_t to,
+                  Statistics *stats) {
+    StatsPartial p;
+    tindex_query_partial(idx, store, from, to, &p);
+    stats_partial_finish(&p, store, stats);
+}
@@ -0,0 +1,45 @@
+// tindex.h - Declaration of tindex.c functions and structures
+
+#ifndef TINDEX_H
+#define TINDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+#include "stats.h"
+
+// Readings per index block, a power of two that divides STORE_CHUNK_SIZE so a
+// block never straddles two store chunks
+#define TINDEX_BLOCK_SHIFT 10
+#define TINDEX_BLOCK_SIZE (1 << TINDEX_BLOCK_SHIFT)
+
+// Declaration of zone map entry: time span and precomputed aggregates of one block
+typedef struct {
+    int64_t min_epoch;
+    int64_t max_epoch;
+    StatsPartial stats;
+} TimeIndexBlock;
+
+// Declaration of time index over a ReadingStore. Only whole blocks are indexed,
+// readings after `indexed` are scanned directly by queries.
+typedef struct {
+    TimeIndexBlock *blocks;
+    size_t block_count;
+    size_t block_capacity;
+    size_t indexed;          // Readings covered by blocks
+    bool sorted;             // Indexed epochs are non-decreasing, enables binary search
+} TimeIndex;
+
+// Declaration of required functions
+void tindex_init(TimeIndex *idx);
+void tindex_free(TimeIndex *idx);
+void tindex_reset(TimeIndex *idx);
+bool tindex_update(TimeIndex *idx, const ReadingStore *store);
+
+void tindex_query_partial(const TimeIndex *idx, const ReadingStore *store, int64_t from, int64_t to,
+                          StatsPartial *out);
+void tindex_query(const TimeIndex *idx, const ReadingStore *store, int64_t from, int64_t to,
+                  Statistics *stats);
+
+#endif
@@ -0,0 +1,206 @@
+// window.c - Sliding Window Aggregates Module
+
+#include "window.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 16   // Starting ring size for time-bounded windows
+
+static size_t next_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static inline size_t ring_mask(const RollingWindow *w) {
+    return w->capacity - 1;
+}
+
+// Deque helpers, indices wrap with the window's ring mask
+static inline uint64_t dq_front(const WindowDeque *d) {
+    return d->pos[d->head];
+}
+
+static inline uint64_t dq_back(const WindowDeque *d, size_t mask) {
+    return d->pos[(d->head + d->len - 1) & mask];
+}
+
+static inline void dq_push_back(WindowDeque *d, uint64_t pos, size_t mask) {
+    d->pos[(d->head + d->len) & mask] = pos;
+    d->len++;
+}
+
+static inline void dq_pop_front(WindowDeque *d, size_t mask) {
+    d->head = (d->head + 1) & mask;
+    d->len--;
+}
+
+static void free_arrays(RollingWindow *w) {
+    free(w->epoch);
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        free(w->ch[c].values);
+        free(w->ch[c].min_q.pos);
+        free(w->ch[c].max_q.pos);
+    }
+}
+
+// Allocates the rings for a new capacity and moves the live samples over
+static bool resize(RollingWindow *w, size_t capacity) {
+    RollingWindow old = *w;
+    size_t old_mask = old.capacity ? old.capacity - 1 : 0;
+    size_t mask = capacity - 1;
+
+    w->capacity = capacity;
+    w->epoch = malloc(capacity * sizeof(int64_t));
+    bool ok = w->epoch != NULL;
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        w->ch[c].values = malloc(capacity * sizeof(double));
+        w->ch[c].min_q.pos = malloc(capacity * sizeof(uint64_t));
+        w->ch[c].max_q.pos = malloc(capacity * sizeof(uint64_t));
+        ok = ok && w->ch[c].values && w->ch[c].min_q.pos && w->ch[c].max_q.pos;
+    }
+    if (!ok) {
+        free_arrays(w);
+        *w = old;
+        return false;
+    }
+
+    // Positions are absolute, so each sample keeps its position in the bigger ring
+    for (uint64_t p = old.tail; p < old.head; p++) {
+        w->epoch[p & mask] = old.epoch[p & old_mask];
+        for (int c = 0; c < WINDOW_CHANNELS; c++) {
+            w->ch[c].values[p & mask] = old.ch[c].values[p & old_mask];
+        }
+    }
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        WindowDeque *qs[2] = { &w->ch[c].min_q, &w->ch[c].max_q };
+        const WindowDeque *olds[2] = { &old.ch[c].min_q, &old.ch[c].max_q };
+        for (int k = 0; k < 2; k++) {
+            for (size_t i = 0; i < olds[k]->len; i++) {
+                qs[k]->pos[i] = olds[k]->pos[(olds[k]->head + i) & old_mask];
+            }
+            qs[k]->head = 0;
+        }
+    }
+
+    free_arrays(&old);
+    return true;
+}
+
+// Creates a window bounded by max_samples and/or span_seconds (0 disables a bound)
+bool window_init(RollingWindow *w, size_t max_samples, int64_t span_seconds) {
+    memset(w, 0, sizeof(*w));
+    w->max_samples = max_samples;
+    w->span_seconds = span_seconds;
+    return resize(w, max_samples ? next_pow2(max_samples) : INITIAL_CAPACITY);
+}
+
+void window_free(RollingWindow *w) {
+    free_arrays(w);
+    memset(w, 0, sizeof(*w));
+}
+
+// Empties the window but keeps its bounds and buffers
+void window_reset(RollingWindow *w) {
+    w->tail = w->head = 0;
+    w->removals = 0;
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        w->ch[c].sum = w->ch[c].sum_sq = 0;
+        w->ch[c].min_q.head = w->ch[c].min_q.len = 0;
+        w->ch[c].max_q.head = w->ch[c].max_q.len = 0;
+    }
+}
+
+// Recomputes the running sums from the ring so rounding cannot accumulate
+static void resum(RollingWindow *w) {
+    size_t mask = ring_mask(w);
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        WindowChannel *ch = &w->ch[c];
+        ch->sum = ch->sum_sq = 0;
+        for (uint64_t p = w->tail; p < w->head; p++) {
+            double d = ch->values[p & mask] - ch->shift;
+            ch->sum += d;
+            ch->sum_sq += d * d;
+        }
+    }
+    w->removals = 0;
+}
+
+static void evict_oldest(RollingWindow *w) {
+    size_t mask = ring_mask(w);
+    uint64_t pos = w->tail;
+
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        WindowChannel *ch = &w->ch[c];
+        double d = ch->values[pos & mask] - ch->shift;
+        ch->sum -= d;
+        ch->sum_sq -= d * d;
+        if (ch->min_q.len && dq_front(&ch->min_q) == pos) dq_pop_front(&ch->min_q, mask);
+        if (ch->max_q.len && dq_front(&ch->max_q) == pos) dq_pop_front(&ch->max_q, mask);
+    }
+    w->tail++;
+    w->removals++;
+}
+
+// Adds a sample and evicts whatever falls out of the window, amortised O(1)
+bool window_push(RollingWindow *w, int64_t epoch, double temperature, double humidity) {
+    if (w->max_samples) {
+        while (window_count(w) >= w->max_samples) evict_oldest(w);
+    }
+    if (w->span_seconds) {
+        while (window_count(w) && w->epoch[w->tail & ring_mask(w)] <= epoch - w->span_seconds) {
+            evict_oldest(w);
+        }
+    }
+    if (window_count(w) == w->capacity && !resize(w, w->capacity * 2)) return false;
+
+    size_t mask = ring_mask(w);
+    size_t slot = w->head & mask;
+    double values[WINDOW_CHANNELS] = { temperature, humidity };
+    bool empty = window_count(w) == 0;
+
+    w->epoch[slot] = epoch;
+    for (int c = 0; c < WINDOW_CHANNELS; c++) {
+        WindowChannel *ch = &w->ch[c];
+        double v = values[c];
+
+        if (empty) {
+            // A fresh shift keeps the shifted sums small
+            ch->shift = v;
+            ch->sum = ch->sum_sq = 0;
+        }
+        ch->values[slot] = v;
+        double d = v - ch->shift;
+        ch->sum += d;
+        ch->sum_sq += d * d;
+
+        // Older samples that can never be the extreme again are dropped
+        while (ch->max_q.len && ch->values[dq_back(&ch->max_q, mask) & mask] <= v) ch->max_q.len--;
+        dq_push_back(&ch->max_q, w->head, mask);
+        while (ch->min_q.len && ch->values[dq_back(&ch->min_q, mask) & mask] >= v) ch->min_q.len--;
+        dq_push_back(&ch->min_q, w->head, mask);
+    }
+    w->head++;
+
+    // One O(n) recompute per n evictions keeps the update amortised O(1)
+    if (w->removals >= w->capacity) resum(w);
+    return true;
+}
+
+void window_get(const RollingWindow *w, WindowChannelId channel, WindowStats *out) {
+    const WindowChannel *ch = &w->ch[channel];
+    size_t n = window_count(w);
+    size_t mask = ring_mask(w);
+
+    memset(out, 0, sizeof(*out));
+    out->count = n;
+    if (n == 0) return;
+
+    double mean_shifted = ch->sum / n;
+    double var = ch->sum_sq / n - mean_shifted * mean_shifted;
+    out->mean = ch->shift + mean_shifted;
+    out->stddev = var > 0 ? sqrt(var) : 0;
+    out->min = ch->values[dq_front(&ch->min_q) & mask];
+    out->max = ch->values[dq_front(&ch->max_q) & mask];
+}
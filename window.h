@@ -0,0 +1,66 @@
+// window.h - Declaration of window.c functions and structures
+
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Channels tracked by every window
+typedef enum {
+    WINDOW_TEMP,
+    WINDOW_HUMID,
+    WINDOW_CHANNELS
+} WindowChannelId;
+
+// Declaration of monotonic deque of absolute sample positions
+typedef struct {
+    uint64_t *pos;
+    size_t head;
+    size_t len;
+} WindowDeque;
+
+// Declaration of per-channel window state: shifted running sums for the mean and
+// standard deviation, monotonic deques for the rolling minimum and maximum
+typedef struct {
+    double *values;        // Ring of sample values
+    double shift;          // First value seen, subtracted before summing
+    double sum, sum_sq;
+    WindowDeque min_q;     // Increasing values, front is the minimum
+    WindowDeque max_q;     // Decreasing values, front is the maximum
+} WindowChannel;
+
+// Declaration of sliding window over the reading stream. A window is bounded by
+// a sample count, a time span, or both; every push is amortised O(1).
+typedef struct {
+    size_t max_samples;     // Count bound (0 = none)
+    int64_t span_seconds;   // Time bound: keeps samples newer than latest - span (0 = none)
+    size_t capacity;        // Ring size, a power of two
+    uint64_t tail, head;    // Absolute positions of the oldest and next sample
+    int64_t *epoch;         // Ring of sample timestamps
+    WindowChannel ch[WINDOW_CHANNELS];
+    size_t removals;        // Evictions since the sums were last recomputed
+} RollingWindow;
+
+// Declaration of structure holding the current window aggregates of a channel
+typedef struct {
+    size_t count;
+    double mean;
+    double min;
+    double max;
+    double stddev;
+} WindowStats;
+
+// Declaration of required functions
+bool window_init(RollingWindow *w, size_t max_samples, int64_t span_seconds);
+void window_free(RollingWindow *w);
+void window_reset(RollingWindow *w);
+bool window_push(RollingWindow *w, int64_t epoch, double temperature, double humidity);
+void window_get(const RollingWindow *w, WindowChannelId channel, WindowStats *out);
+
+static inline size_t window_count(const RollingWindow *w) {
+    return (size_t)(w->head - w->tail);
+}
+
+#endif
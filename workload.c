@@ -0,0 +1,179 @@
+// workload.c - Synthetic Workload Generator Module
+
+#include "workload.h"
+#include "platform.h"
+#include "store.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TWO_PI 6.283185307179586
+#define DAY_SECONDS 86400.0
+
+// Sum of four 16-bit uniforms, scaled to mean 0 and standard deviation 1.
+// Close enough to a normal distribution for sensor noise and much cheaper.
+#define NOISE_MEAN (4 * 32767.5)
+#define NOISE_SCALE (1.0 / 37837.2)   // 1 / (65536 * sqrt(4 / 12))
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Expands a 64-bit seed into the full state, as recommended by the xoshiro authors
+void xoshiro_seed(Xoshiro256 *r, uint64_t seed) {
+    for (int i = 0; i < 4; i++) r->s[i] = splitmix64(&seed);
+}
+
+// Seed for runs that should differ each time
+uint64_t workload_clock_seed(void) {
+    return (uint64_t)time(NULL) ^ (uint64_t)(monotonic_seconds() * 1e9);
+}
+
+// Settings close to the old simulator: one sensor every 28.8 minutes from today's
+// midnight, levels around the warning and alert thresholds
+void workload_defaults(WorkloadConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->seed = 1;
+    cfg->start_epoch = random_start_epoch();
+    cfg->interval_seconds = 1728;
+    cfg->sensors = 1;
+    cfg->temp = (SignalModel){ 60.0, 6.0, 15.0, 0.0, 1.5, 2.0 };
+    cfg->humid = (SignalModel){ 62.0, 8.0, 5.0, 0.0, 2.0, 3.0 };
+    cfg->spike_rate = 0.001;
+    cfg->spike_size = 12.0;
+    cfg->dropout_rate = 0.0;
+}
+
+// Readings until the next event of a given rate, a geometric gap. Drawing the
+// gap once per event replaces a random draw and a compare per reading.
+static uint64_t event_gap(Xoshiro256 *rng, double rate) {
+    if (rate <= 0) return UINT64_MAX;
+    if (rate >= 1) return 0;
+    double u = 1.0 - xoshiro_double(rng);  // In (0, 1]
+    double gap = floor(log(u) / log1p(-rate));
+    return gap < 1e18 ? (uint64_t)gap : UINT64_MAX;
+}
+
+// Daily phase at the current step, computed exactly
+static void resync_phase(Workload *w) {
+    int64_t epoch = w->cfg.start_epoch + (int64_t)w->step * w->cfg.interval_seconds;
+    double day = fmod((double)epoch, DAY_SECONDS);
+    w->phase_cos = cos(TWO_PI * day / DAY_SECONDS);
+    w->phase_sin = sin(TWO_PI * day / DAY_SECONDS);
+}
+
+bool workload_init(Workload *w, const WorkloadConfig *cfg) {
+    memset(w, 0, sizeof(*w));
+    w->cfg = *cfg;
+    if (w->cfg.sensors < 1) w->cfg.sensors = 1;
+    if (w->cfg.interval_seconds < 1) w->cfg.interval_seconds = 1;
+    xoshiro_seed(&w->rng, cfg->seed);
+
+    w->offsets = malloc(sizeof(double) * 2 * (size_t)w->cfg.sensors);
+    if (!w->offsets) return false;
+    for (int s = 0; s < w->cfg.sensors; s++) {
+        w->offsets[2 * s] = (xoshiro_double(&w->rng) * 2 - 1) * w->cfg.temp.sensor_spread;
+        w->offsets[2 * s + 1] = (xoshiro_double(&w->rng) * 2 - 1) * w->cfg.humid.sensor_spread;
+    }
+    if (w->cfg.sensors == 1) w->offsets[0] = w->offsets[1] = 0;  // A lone sensor is the reference
+
+    double step = TWO_PI * (double)w->cfg.interval_seconds / DAY_SECONDS;
+    w->step_cos = cos(step);
+    w->step_sin = sin(step);
+    w->temp_shift_cos = cos(TWO_PI * w->cfg.temp.peak_hour / 24.0);
+    w->temp_shift_sin = sin(TWO_PI * w->cfg.temp.peak_hour / 24.0);
+    w->humid_shift_cos = cos(TWO_PI * w->cfg.humid.peak_hour / 24.0);
+    w->humid_shift_sin = sin(TWO_PI * w->cfg.humid.peak_hour / 24.0);
+    w->until_spike = event_gap(&w->rng, w->cfg.spike_rate);
+    w->until_dropout = event_gap(&w->rng, w->cfg.dropout_rate);
+    resync_phase(w);
+    return true;
+}
+
+void workload_free(Workload *w) {
+    free(w->offsets);
+    w->offsets = NULL;
+}
+
+static inline double noise(Xoshiro256 *rng) {
+    uint64_t x = xoshiro_next(rng);
+    double sum = (double)((x & 0xFFFF) + ((x >> 16) & 0xFFFF) + ((x >> 32) & 0xFFFF) + (x >> 48));
+    return (sum - NOISE_MEAN) * NOISE_SCALE;
+}
+
+// Noise-free levels of the current step: cos(phase - peak) through the angle difference
+static void step_levels(Workload *w) {
+    double days = (double)((int64_t)w->step * w->cfg.interval_seconds) / DAY_SECONDS;
+    double temp_cycle = w->phase_cos * w->temp_shift_cos + w->phase_sin * w->temp_shift_sin;
+    double humid_cycle = w->phase_cos * w->humid_shift_cos + w->phase_sin * w->humid_shift_sin;
+    w->temp_level = w->cfg.temp.base + w->cfg.temp.diurnal * temp_cycle + w->cfg.temp.drift_per_day * days;
+    w->humid_level = w->cfg.humid.base + w->cfg.humid.diurnal * humid_cycle + w->cfg.humid.drift_per_day * days;
+}
+
+// Moves to the next sample time, the phase is rotated instead of calling sin/cos
+static void next_step(Workload *w) {
+    w->step++;
+    w->sensor = 0;
+    if (w->step % WORKLOAD_RESYNC_STEPS == 0) {
+        resync_phase(w);  // Bounds the rounding error of the rotation
+    } else {
+        double c = w->phase_cos * w->step_cos - w->phase_sin * w->step_sin;
+        w->phase_sin = w->phase_sin * w->step_cos + w->phase_cos * w->step_sin;
+        w->phase_cos = c;
+    }
+}
+
+// Appends n readings, continuing the run of earlier calls. Readings are built in
+// column blocks and copied into the store in bulk. Returns the number appended.
+size_t workload_generate(Workload *w, ReadingStore *store, size_t n) {
+    int64_t epoch[WORKLOAD_BLOCK];
+    double temp[WORKLOAD_BLOCK];
+    double humid[WORKLOAD_BLOCK];
+    int seq_no[WORKLOAD_BLOCK];
+    int32_t sensor_id[WORKLOAD_BLOCK];
+    bool multi = w->cfg.sensors > 1;
+    size_t done = 0;
+
+    while (done < n) {
+        size_t k = 0;
+        while (k < WORKLOAD_BLOCK && done + k < n) {
+            if (w->sensor == 0) step_levels(w);
+            int s = w->sensor;
+            double t = w->temp_level + w->offsets[2 * s] + w->cfg.temp.noise * noise(&w->rng);
+            double h = w->humid_level + w->offsets[2 * s + 1] + w->cfg.humid.noise * noise(&w->rng);
+
+            bool keep = true;
+            if (w->until_dropout-- == 0) {
+                keep = false;
+                w->until_dropout = event_gap(&w->rng, w->cfg.dropout_rate);
+            }
+            if (w->until_spike-- == 0) {
+                // Rare path: which channel and which direction
+                uint64_t r = xoshiro_next(&w->rng);
+                double size = (r & 1) ? w->cfg.spike_size : -w->cfg.spike_size;
+                if (r & 2) t += size;
+                else h += size;
+                w->until_spike = event_gap(&w->rng, w->cfg.spike_rate);
+            }
+
+            if (keep) {
+                epoch[k] = w->cfg.start_epoch + (int64_t)w->step * w->cfg.interval_seconds;
+                temp[k] = t;
+                humid[k] = h;
+                seq_no[k] = (int)(w->step + 1);
+                sensor_id[k] = multi ? s + 1 : 0;
+                k++;
+            }
+            if (++w->sensor == w->cfg.sensors) next_step(w);
+        }
+
+        size_t added = store_append_block(store, epoch, temp, humid, seq_no, sensor_id, k);
+        done += added;
+        if (added < k) break;  // Out of memory
+    }
+    return done;
+}
@@ -0,0 +1,90 @@
+// workload.h - Declaration of workload.c functions and structures
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "simulator.h"
+
+#define WORKLOAD_BLOCK 1024          // Readings generated per store_append_block() call
+#define WORKLOAD_RESYNC_STEPS 4096   // Steps between exact sin/cos of the daily phase
+
+// Declaration of xoshiro256** generator state, never all zero
+typedef struct {
+    uint64_t s[4];
+} Xoshiro256;
+
+// Declaration of one channel of the signal model
+typedef struct {
+    double base;              // Mean level
+    double diurnal;           // Amplitude of the daily cycle
+    double peak_hour;         // Hour of day of the daily maximum
+    double drift_per_day;     // Slow linear change from the start of the run
+    double noise;             // Standard deviation of the per-reading noise
+    double sensor_spread;     // Calibration offsets of the sensors lie in +/- this
+} SignalModel;
+
+// Declaration of workload settings. Same settings and seed, same readings.
+typedef struct {
+    uint64_t seed;
+    int64_t start_epoch;      // Wall-clock epoch of the first sample time
+    int64_t interval_seconds; // Sample rate: time between two readings of a sensor
+    int sensors;              // 1 = sensor id 0, more = ids 1 .. sensors, round robin
+    SignalModel temp;
+    SignalModel humid;
+    double spike_rate;        // Probability of a spike per reading
+    double spike_size;        // Added to (or taken from) one channel on a spike
+    double dropout_rate;      // Probability that a sensor misses a sample time
+} WorkloadConfig;
+
+// Declaration of generator state, readings continue where the last call stopped
+typedef struct {
+    WorkloadConfig cfg;
+    Xoshiro256 rng;
+    uint64_t step;            // Sample time index
+    int sensor;               // Next sensor within the current step
+    double *offsets;          // Per-sensor calibration offsets, temperature then humidity
+    double phase_cos, phase_sin;  // Daily phase of the current step
+    double step_cos, step_sin;    // Rotation by one interval
+    double temp_level;        // Noise-free values of the current step
+    double humid_level;
+    double temp_shift_cos, temp_shift_sin;    // Peak hour as a phase shift
+    double humid_shift_cos, humid_shift_sin;
+    uint64_t until_spike;     // Readings before the next spike / dropout, drawn
+    uint64_t until_dropout;   // as geometric gaps so quiet readings cost nothing
+} Workload;
+
+static inline uint64_t xoshiro_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Next 64 random bits (xoshiro256**)
+static inline uint64_t xoshiro_next(Xoshiro256 *r) {
+    uint64_t *s = r->s;
+    uint64_t result = xoshiro_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = xoshiro_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform double in [0, 1)
+static inline double xoshiro_double(Xoshiro256 *r) {
+    return (double)(xoshiro_next(r) >> 11) * 0x1.0p-53;
+}
+
+// Declaration of required functions
+void xoshiro_seed(Xoshiro256 *r, uint64_t seed);
+uint64_t workload_clock_seed(void);
+void workload_defaults(WorkloadConfig *cfg);
+bool workload_init(Workload *w, const WorkloadConfig *cfg);
+void workload_free(Workload *w);
+size_t workload_generate(Workload *w, ReadingStore *store, size_t n);
+
+#endif